@@ -7,6 +7,12 @@
 // Goldilocks linear threshold functions (GLTFs). The program generates all 
 // hypercomplete boolean functions on n variables; writes them to file.
 // These are then read and tested for separability by GoldilocksTestParallel.cpp
+// The search tree is split into subtrees which are shared among an array
+// of worker threads by work-stealing.
+// The workers pause every so often to save the state of the DFS, so that a
+// run that is stopped can be picked up again with --resume.
+// The generator is compiled once for each n from 3 to 10 (see goldenum.cpp),
+// and --n picks the one to run.
 
 // This piece of the algorithm can be found in:
 // R. O. Winder. Enumeration of seven-argument threshold functions. 
@@ -17,7 +23,20 @@
 #include "bigint.h"
 #include "blockingconcurrentqueue.h"
 #include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <climits>
+#include <cmath>
+#include <immintrin.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <mutex>
+#include <atomic>
+#include <deque>
+#include <algorithm>
+#include <queue>
 #include <thread>
 #include <condition_variable>
 #include <chrono>
@@ -25,131 +44,61 @@
 #include <sstream>
 #include <new>
 #include <vector>
+#include <memory>
 #include <iostream>
 
 
-//const unsigned n=3; const unsigned tn = 8;
-//const unsigned n=4; const unsigned tn = 16;
-//const unsigned n=5; const unsigned tn = 32; 
-//const unsigned n=6; const unsigned tn = 64; 
-//const unsigned n=7; const unsigned tn = 128; 
-//const unsigned n=8; const unsigned tn = 256; 
-//
-const unsigned n=9; const unsigned tn = 512;
+using namespace std;
 
-vector<int> Great[tn],Less[tn];
-
-#include "functions.cpp"
-
-// Store output 
-char outname[] = "/home/fas/payne_sam/cjh69/project/GoldCands9.dat";
-
-int buflen; 						// Write buffer length (in bitsets)
-const int bufsize = 2097152; 		// Write buffer size (in chars) 
-									// 		Must be mult of tn, 
-									//		smaller version 65536
-int bufi = 0; 						// Number of bitsets currently in buffer
-
-char buffer[bufsize];				// Write buffer
-
-// Buffered write of bitset data to file
-void write(ofstream& outfile, bitset<tn>& F) {
-	static int buflen = bufsize*8/tn;
-	static const int charperbs = tn/8;
-	for (int ci = 1; ci <= charperbs; ci++){
-		char c = 0;
-		for (int bi = 7; bi >= 0; bi--) {
-			if (F.test(tn - ci*8 + bi)){
-				c |= 0x1;
-			}
-			c <<= 1;
-		}
-
-		buffer[bufi*charperbs + ci - 1] = c;
-	}
-	bufi++;
-
-	if (bufi == buflen) { // Flush buffer
-		outfile.write(buffer, bufsize);
-		bufi = 0;
-	}
+// One instantiation of the generator per supported n, each with its own
+// fixed-size bitsets and tables. The one for n=k is dimk::run.
+namespace dim3 { const unsigned n=3;
+#include "goldenum.cpp"
 }
-
-// Final flush of buffer
-void flush (ofstream& outfile) {
-	outfile.write(buffer, bufi);
+namespace dim4 { const unsigned n=4;
+#include "goldenum.cpp"
 }
-
-void initless(bitset<tn> less[]);   //Initializes in.
-
-int main(){
-	ofstream outfile(outname, ios::binary);
-
-	lessgreatinit(Great,Less);
-	bitset<tn> lessa[tn]; initless(lessa);
-
-	lint tcount=0,				        	//Number of testcases.
-	BigInt septotal(tcount);
-
-	vector< bitset<tn> > stk;           	//A stack to hold fcns to process
-	bitset<tn> F,free; 
-	F.reset(); free.set();
-
-	stk.push_back(F);  						//Push the first fcn on the stack. 
-	stk.push_back(free);					//Along with its free elements.
-
- 	while(!stk.empty() ){
-		free = stk.back();stk.pop_back();	//Pop the top set and it's free 
-		F = stk.back(); stk.pop_back(); 	//variables off the stack.
-		while(free.count()>0){      
-			int j = tn-1;         			//Find the largest free element.
-			while(!free.test(j))
-				j--;
-			stk.push_back(F);         		//Push a copy of F onto the stack.
-			stk.push_back(free);
-
-			free &= lessa[j];         		//Remove elements less than j.
-
-		}
-		tcount++;
-		write(outfile, F);
-
-		if(!stk.empty()){
-			free = stk.back();stk.pop_back(); //Pop the top set and it's free 
-			F = stk.back(); stk.pop_back();   //variables off the stack.
-
-			unsigned j = tn-1;        		//Find the largest free element.
-			while(!free.test(j))
-				j--;
-			F.set(j); free.reset(j);
-			if(posn(j,n-1) && posn(j,n-2) ){
-				unsigned z = comp(n-2,j); set(z,n-1);
-				free&=lessa[z];
-			}
-			stk.push_back( F );				//Push the first set on the stack. 
-			stk.push_back( free );        	//Along with it's free elements.
-		}
-	}
-
-	flush(outfile);
-	outfile.close();
-
-	cout<<"\nNumber Generated : "<<tcount<<endl;
-	return 0;
+namespace dim5 { const unsigned n=5;
+#include "goldenum.cpp"
+}
+namespace dim6 { const unsigned n=6;
+#include "goldenum.cpp"
+}
+namespace dim7 { const unsigned n=7;
+#include "goldenum.cpp"
+}
+namespace dim8 { const unsigned n=8;
+#include "goldenum.cpp"
+}
+namespace dim9 { const unsigned n=9;
+#include "goldenum.cpp"
+}
+namespace dim10 { const unsigned n=10;
+#include "goldenum.cpp"
 }
 
-//*************************************************************************
-//*************************************************************************
-
-void initless(bitset<tn> less[]){      
-	for(int i=0;i<tn;i++){
-		less[i]=bitset<tn>();
-		less[i].set();
-		less[i].reset(i);
-		for(int j=0;j<tn;j++){
-			if( lessdot(n,j,i) )
-				less[i].reset(j);
-		}
+// Usage: GoldilocksEnumParallel [--n k] [--check] [--checkpoint s] [--resume]
+//                               [--shard k/N] [--threads k]
+// n defaults to 9. --check counts any function generated out of canonical form.
+// --threads sets the number of enumerator workers (default 16).
+// --shard k/N generates only the k-th of N parts of the tree, to its own file;
+// run each part (on as many nodes as are free) and test the files separately.
+int main(int argc, char* argv[]) {
+	int n = 9;
+	for (int a = 1; a < argc-1; a++)
+		if (strcmp(argv[a], "--n") == 0)
+			n = atoi(argv[a+1]);
+
+	switch (n) {
+		case 3: return dim3::run(argc, argv);
+		case 4: return dim4::run(argc, argv);
+		case 5: return dim5::run(argc, argv);
+		case 6: return dim6::run(argc, argv);
+		case 7: return dim7::run(argc, argv);
+		case 8: return dim8::run(argc, argv);
+		case 9: return dim9::run(argc, argv);
+		case 10: return dim10::run(argc, argv);
 	}
+	cerr << "n must be between 3 and 10" << endl;
+	return(1);
 }
-
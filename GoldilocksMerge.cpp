@@ -0,0 +1,197 @@
+// GoldilocksMerge.cpp
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// Adds up the results of a sharded run. GoldilocksEnumParallel --shard k/N
+// splits the candidates over N files, and GoldilocksTestParallel --shard k/M
+// splits the records of one file over M processes; each tester ends its
+// counts file with a Result line, and this program is given all the counts
+// files. Before printing the totals it checks that they cover every
+// candidate exactly once: the tester shards of each candidate file must
+// tile its records, with checksums adding up to the one in its header, and
+// every enumerator shard must be there. Where the number of candidates on
+// n variables is known, the number tested must match it.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include "goldformat.h"
+
+using namespace std;
+
+// Parses a decimal 128-bit number; false if it is malformed or too large
+bool parsewide(const std::string& s, wide& x) {
+	x = 0;
+	if (s.empty())
+		return false;
+	for (size_t i = 0; i < s.size(); i++) {
+		if (s[i] < '0' || s[i] > '9')
+			return false;
+		if (__builtin_mul_overflow(x, (wide) 10, &x)
+				|| __builtin_add_overflow(x, (wide) (s[i] - '0'), &x))
+			return false;
+	}
+	return true;
+}
+
+// The Result line of one tester shard
+struct Result {
+	std::string name;					// Counts file it came from
+	int n;
+	uint64_t file, files;				// Enumerator shard of the candidate file
+	uint64_t filecount, filesum;		// Its header
+	uint64_t lo, hi;					// Records tested
+	uint64_t checksum;					// Their checksum
+	wide tested, GLcountSn, GLcount, PScountSn, PScount;
+};
+
+// Reads the last Result line of a counts file
+bool readresult(const char* name, Result& r) {
+	ifstream in(name);
+	std::string line, last;
+	while (getline(in, line))
+		if (line.compare(0, 7, "Result ") == 0)
+			last = line;
+	if (last.empty())
+		return false;
+
+	map<std::string, std::string> f;
+	std::istringstream words(last.substr(7));
+	std::string w;
+	while (words >> w) {
+		size_t eq = w.find('=');
+		if (eq == std::string::npos)
+			return false;
+		f[w.substr(0, eq)] = w.substr(eq+1);
+	}
+
+	r.name = name;
+	wide x;
+	unsigned long long a, b;
+	if (sscanf(f["file"].c_str(), "%llu/%llu", &a, &b) != 2)
+		return false;
+	r.file = a; r.files = b;
+	if (sscanf(f["records"].c_str(), "%llu-%llu", &a, &b) != 2)
+		return false;
+	r.lo = a; r.hi = b;
+	if (!parsewide(f["n"], x)) return false;
+	r.n = (int) x;
+	if (!parsewide(f["filecount"], x)) return false;
+	r.filecount = (uint64_t) x;
+	if (!parsewide(f["filesum"], x)) return false;
+	r.filesum = (uint64_t) x;
+	if (!parsewide(f["checksum"], x)) return false;
+	r.checksum = (uint64_t) x;
+	return parsewide(f["tested"], r.tested) && parsewide(f["GLSn"], r.GLcountSn)
+		&& parsewide(f["GL"], r.GLcount) && parsewide(f["PSSn"], r.PScountSn)
+		&& parsewide(f["PS"], r.PScount);
+}
+
+bool byrecords(const Result& x, const Result& y) {
+	return x.lo < y.lo;
+}
+
+// Usage: GoldilocksMerge counts-file...
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		cerr << "Usage: GoldilocksMerge counts-file..." << endl;
+		return(1);
+	}
+
+	// The results, by the enumerator shard of their candidate file
+	map<uint64_t, vector<Result>> shards;
+	Result first;
+	for (int a = 1; a < argc; a++) {
+		Result r;
+		if (!readresult(argv[a], r)) {
+			cerr << argv[a] << ": no Result line" << endl;
+			return(1);
+		}
+		if (a == 1)
+			first = r;
+		if (r.n != first.n || r.files != first.files
+				|| r.file >= (r.files == 0 ? 1 : r.files)) {
+			cerr << argv[a] << ": not from the same run as " << first.name << endl;
+			return(1);
+		}
+		shards[r.file].push_back(r);
+	}
+
+	// Every candidate file must be there, and each tested exactly once
+	uint64_t files = first.files == 0 ? 1 : first.files;
+	bool ok = true;
+	for (uint64_t k = 0; k < files; k++) {
+		if (shards.count(k) == 0) {
+			cerr << "Missing the results for candidate file " << k << "/" << files << endl;
+			ok = false;
+			continue;
+		}
+		vector<Result>& rs = shards[k];
+		sort(rs.begin(), rs.end(), byrecords);
+		uint64_t next = 0, checksum = 0;
+		for (size_t i = 0; i < rs.size(); i++) {
+			if (rs[i].filecount != rs[0].filecount || rs[i].filesum != rs[0].filesum) {
+				cerr << rs[i].name << ": tested a different candidate file than "
+					<< rs[0].name << endl;
+				ok = false;
+			}
+			if (rs[i].lo != next) {
+				cerr << "Candidate file " << k << "/" << files << ": records from "
+					<< next << " to " << rs[i].lo << " tested "
+					<< (rs[i].lo > next ? "by nobody" : "twice") << endl;
+				ok = false;
+			}
+			next = rs[i].hi;
+			checksum += rs[i].checksum;
+		}
+		if (next != rs[0].filecount) {
+			cerr << "Candidate file " << k << "/" << files << ": records from "
+				<< next << " on not tested" << endl;
+			ok = false;
+		}
+		else if (checksum != rs[0].filesum) {
+			cerr << "Candidate file " << k << "/" << files
+				<< ": checksum mismatch -- results invalid" << endl;
+			ok = false;
+		}
+	}
+	if (!ok)
+		return(1);
+
+	wide tested = 0, GLcountSn = 0, GLcount = 0, PScountSn = 0, PScount = 0;
+	bool overflow = false;
+	for (auto& s : shards)
+		for (size_t i = 0; i < s.second.size(); i++) {
+			Result& r = s.second[i];
+			overflow |= __builtin_add_overflow(tested, r.tested, &tested);
+			overflow |= __builtin_add_overflow(GLcountSn, r.GLcountSn, &GLcountSn);
+			overflow |= __builtin_add_overflow(GLcount, r.GLcount, &GLcount);
+			overflow |= __builtin_add_overflow(PScountSn, r.PScountSn, &PScountSn);
+			overflow |= __builtin_add_overflow(PScount, r.PScount, &PScount);
+		}
+	if (overflow) {
+		cerr << "Totals overflowed -- results invalid" << endl;
+		return(1);
+	}
+	if (knowntotal(first.n) >= 0 && tested != (wide) knowntotal(first.n)) {
+		cerr << "Number tested " << widestr(tested) << " differs from the "
+			<< knowntotal(first.n) << " candidates on " << first.n
+			<< " variables -- results invalid" << endl;
+		return(1);
+	}
+
+	cout << "Merged " << argc-1 << " results.\n";
+	cout << "n = " << first.n << "\n";
+	cout << "Number Tested : " << widestr(tested) << "\n";
+	cout << "Number Goldilocks(/Sn): " << widestr(GLcountSn) << "\n";
+	cout << "Number Goldilocks: " << widestr(GLcount) << "\n";
+	cout << "Number SemiGold(/Sn): " << widestr(PScountSn) << "\n";
+	cout << "Number SemiGold: " << widestr(PScount) << "\n";
+	return 0;
+}
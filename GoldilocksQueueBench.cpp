@@ -0,0 +1,134 @@
+// GoldilocksQueueBench.cpp
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// Measures the cost per candidate of moving functions through candq, the
+// BoundedQueue between the enumerator threads and the testers of
+// GoldilocksTestParallel --fused. Producers enqueue copies of a bitset<512>
+// (an n=9 candidate) and testers only take them off, so the time is all
+// queue overhead. Batch size 1 uses enqueue and wait_dequeue per item, as
+// before --batch; larger sizes use the bulk calls, as the tester does now.
+
+#include "boundedqueue.h"
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef bitset<512> Cand;
+
+const int QUEUEMAX = 5000;			// As in goldtest.cpp
+
+// The kill token of goldtest.cpp: not a positive function
+bool killtoken(const Cand& F) {
+	return F.test(0) && !F.test(1);
+}
+
+void producer(BoundedQueue<Cand>& q, long items, int batch) {
+	moodycamel::ProducerToken tok(q.q);
+	Cand F;
+	F.set(1);
+	if (batch == 1) {
+		for (long i = 0; i < items; i++)
+			q.enqueue(tok, F);
+		return;
+	}
+	vector<Cand> buf(batch, F);
+	for (long i = 0; i < items; i += batch)
+		q.enqueue_bulk(tok, buf.begin(), min<long>(batch, items - i));
+}
+
+void tester(BoundedQueue<Cand>& q, int batch, long& taken) {
+	moodycamel::ConsumerToken tok(q.q);
+	taken = 0;
+	if (batch == 1) {
+		Cand F;
+		while (true) {
+			q.wait_dequeue(tok, F);
+			if (killtoken(F))
+				return;
+			taken++;
+		}
+	}
+	vector<Cand> buf(batch);
+	while (true) {
+		size_t got = q.wait_dequeue_bulk(tok, buf.begin(), batch);
+		for (size_t i = 0; i < got; i++) {
+			if (killtoken(buf[i])) {	// Pass on the rest, as nextcand does
+				if (i+1 < got)
+					q.enqueue_bulk(buf.begin() + i+1, got - (i+1));
+				return;
+			}
+			taken++;
+		}
+	}
+}
+
+// Nanoseconds per item for one run
+double run(long items, int producers, int testers, int batch) {
+	BoundedQueue<Cand> q(QUEUEMAX);
+	vector<long> taken(testers);
+	auto start = chrono::steady_clock::now();
+	vector<thread> ts, ps;
+	for (int i = 0; i < testers; i++)
+		ts.push_back(thread(tester, ref(q), batch, ref(taken[i])));
+	for (int i = 0; i < producers; i++)
+		ps.push_back(thread(producer, ref(q), items/producers, batch));
+	for (auto& t : ps)
+		t.join();
+	q.drain();
+	Cand kill;
+	kill.set(0);
+	for (int i = 0; i < testers; i++)
+		q.enqueue_bulk(&kill, 1);
+	long total = 0;
+	for (int i = 0; i < testers; i++) {
+		ts[i].join();
+		total += taken[i];
+	}
+	double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+	if (total != producers*(items/producers))
+		cerr << "Lost items: " << total << " of " << producers*(items/producers) << endl;
+	return ns/total;
+}
+
+// Usage: GoldilocksQueueBench [--items N] [--producers P] [--testers T] [batch ...]
+int main(int argc, char* argv[]) {
+	long items = 10000000;
+	int producers = 2, testers = 14;
+	vector<int> batches;
+	for (int a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "--items") == 0 && a+1 < argc)
+			items = atol(argv[++a]);
+		else if (strcmp(argv[a], "--producers") == 0 && a+1 < argc)
+			producers = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--testers") == 0 && a+1 < argc)
+			testers = atoi(argv[++a]);
+		else if (atoi(argv[a]) >= 1)
+			batches.push_back(atoi(argv[a]));
+		else {
+			cerr << "Usage: GoldilocksQueueBench [--items N] [--producers P] "
+				<< "[--testers T] [batch ...]" << endl;
+			return(1);
+		}
+	}
+	if (batches.empty())
+		batches = {1, 8, 64, 256};
+	for (int b : batches)
+		if (b*producers > QUEUEMAX) {		// Batches must fit in the queue
+			cerr << "Batch size must be at most " << QUEUEMAX/producers << endl;
+			return(1);
+		}
+
+	printf("%ld items, %d producers, %d testers, %u hardware threads\n",
+		items, producers, testers, thread::hardware_concurrency());
+	for (int b : batches)
+		printf("batch %4d: %8.1f ns/item\n", b, run(items, producers, testers, b));
+	return 0;
+}
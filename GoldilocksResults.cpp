@@ -0,0 +1,109 @@
+// GoldilocksResults.cpp
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// Reads a result file written by GoldilocksTestParallel --results (the
+// format is described in resultfile.cpp). The file is mapped into memory
+// and its records scanned in place, so totalling even a file of a billion
+// LTFs runs at the speed of memory rather than of parsing. Prints the
+// number of LTFs and the totals of the four counts, which match those of
+// the run that wrote it; --dump also prints each record as a line of text.
+// It fails if any record holds no verified weights (see resultfile.cpp).
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "goldformat.h"
+
+using namespace std;
+
+// Prints one record: its key, its counts and any weights and threshold
+void dump(const ResultHeader& h, unsigned keywords, const uint64_t* rec) {
+	if (h.flags & RESINDEX)
+		printf("%llu", (unsigned long long) rec[0]);
+	else
+		for (int i = keywords-1; i >= 0; i--)
+			printf("%016llx", (unsigned long long) rec[i]);
+	const uint64_t* c = rec + keywords;
+	printf(";%lld,%lld,%lld,%lld", (long long) c[0], (long long) c[1],
+		(long long) c[2], (long long) c[3]);
+	if (h.flags & RESWEIGHTS) {
+		const int32_t* w = (const int32_t*) (c + 4);
+		printf(";");
+		for (unsigned j = 0; j < h.n; j++)
+			printf("%d%s", w[j], j+1 < h.n ? "," : "");
+		printf(";%d", w[h.n]);
+	}
+	printf("\n");
+}
+
+// Usage: GoldilocksResults file [--dump]
+int main(int argc, char* argv[]) {
+	if (argc < 2 || (argc == 3 && strcmp(argv[2], "--dump") != 0) || argc > 3) {
+		cerr << "Usage: GoldilocksResults file [--dump]" << endl;
+		return(1);
+	}
+	bool dumping = argc == 3;
+
+	int fd = open(argv[1], O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(ResultHeader)) {
+		cerr << "Cannot read " << argv[1] << endl;
+		return(1);
+	}
+	size_t length = st.st_size;
+	void* base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		cerr << "Cannot map " << argv[1] << endl;
+		return(1);
+	}
+	madvise(base, length, MADV_SEQUENTIAL);
+
+	// Check n before deriving the record layout from it
+	ResultHeader h;
+	memcpy(&h, base, sizeof(h));
+	bool known = memcmp(h.magic, "GOLDRSLT", 8) == 0 && h.version == resversion
+		&& h.n >= 3 && h.n <= 10;
+	unsigned keywords = 0, weightwords = 0;
+	if (known) {
+		keywords = (h.flags & RESINDEX) ? 1 : (((1u << h.n) + 63)/64);
+		weightwords = (h.flags & RESWEIGHTS) ? (h.n+2)/2 : 0;
+	}
+	if (!known || h.recwords != keywords + 4 + weightwords
+			|| (length - sizeof(h))/(8*h.recwords) < h.count) {
+		cerr << argv[1] << " is not a complete result file" << endl;
+		munmap(base, length);
+		return(1);
+	}
+
+	// One pass over the records, summing the counts
+	const uint64_t* recs = (const uint64_t*) ((char*) base + sizeof(h));
+	wide total[4] = {0, 0, 0, 0};
+	for (uint64_t r = 0; r < h.count; r++) {
+		const uint64_t* rec = recs + r*h.recwords;
+		for (int i = 0; i < 4; i++)
+			total[i] += rec[keywords + i];
+		if (dumping)
+			dump(h, keywords, rec);
+	}
+	munmap(base, length);
+
+	cout << "n = " << h.n << "\n";
+	cout << "Number of LTFs : " << h.count << "\n";
+	cout << "Number Goldilocks(/Sn): " << widestr(total[1]) << "\n";
+	cout << "Number Goldilocks: " << widestr(total[0]) << "\n";
+	cout << "Number SemiGold(/Sn): " << widestr(total[3]) << "\n";
+	cout << "Number SemiGold: " << widestr(total[2]) << "\n";
+	if (h.unchecked > 0) {
+		cerr << h.unchecked << " records have no verified weights (zeros)" << endl;
+		return(1);
+	}
+	return 0;
+}
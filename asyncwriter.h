@@ -0,0 +1,92 @@
+// asyncwriter.h
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// A text file written by a thread of its own. Callers hand their strings to
+// a lock-free moodycamel::BlockingConcurrentQueue and return at once; the
+// writer thread keeps the file open, appends whatever has arrived in bulk
+// and flushes once the queue goes quiet, or at least every flushms
+// milliseconds while it does not. Strings from one thread keep their order.
+
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include "blockingconcurrentqueue.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AsyncWriter {
+public:
+	AsyncWriter() : stop(false), running(false), flushms(1000) {}
+	~AsyncWriter() { close(); }
+
+	// Opens name for appending and starts the writer thread
+	bool open(const std::string& name, int flush = 1000) {
+		file.open(name, std::ios::app);
+		if (!file)
+			return false;
+		flushms = flush;
+		stop = false;
+		running = true;
+		thread = std::thread(&AsyncWriter::run, this);
+		return true;
+	}
+
+	// Queues s to be written; never waits on the file
+	void write(std::string s) {
+		if (running)
+			q.enqueue(std::move(s));
+	}
+
+	// Writes everything queued so far, then closes the file
+	void close() {
+		if (!running)
+			return;
+		stop.store(true, std::memory_order_release);
+		q.enqueue(std::string());		// Wake the writer
+		thread.join();
+		file.close();
+		running = false;
+	}
+
+private:
+	void run() {
+		const size_t BULK = 256;
+		std::vector<std::string> batch(BULK);
+		auto lastflush = std::chrono::steady_clock::now();
+		bool dirty = false;
+		while (true) {
+			// Seen before the dequeue, so whatever came before close is written
+			bool stopping = stop.load(std::memory_order_acquire);
+			size_t got = stopping ? q.try_dequeue_bulk(batch.begin(), BULK)
+				: q.wait_dequeue_bulk_timed(batch.begin(), BULK,
+					std::chrono::milliseconds(flushms));
+			for (size_t i = 0; i < got; i++)
+				file << batch[i];
+			dirty |= got > 0;
+
+			auto now = std::chrono::steady_clock::now();
+			if (dirty && (got < BULK
+					|| now - lastflush >= std::chrono::milliseconds(flushms))) {
+				file.flush();
+				dirty = false;
+				lastflush = now;
+			}
+			if (stopping && got == 0)
+				break;
+		}
+	}
+
+	moodycamel::BlockingConcurrentQueue<std::string> q;
+	std::ofstream file;
+	std::thread thread;
+	std::atomic<bool> stop;
+	bool running;
+	int flushms;
+};
+
+#endif
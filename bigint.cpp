@@ -1,92 +1,221 @@
 #include "bigint.h"
+#include <immintrin.h>
+#include <cstdlib>
+
 BigInt::BigInt( unsigned long long val){
-  size=30;
-  unsigned max=~0; 
-  base=1;
-  while(base*10<max)
-    base*=10;
+  small=val;
+  spilled=false;
+}
 
-  for(int i=0;i<size;i++)
-    number[i]=0;
-    
-  for(int i=0;val!=0 && i<size; i++){
-    number[i] = val%base;
-    val/=base;
-  } 
+// From 30 decimal limbs of base 10^9, least significant first
+BigInt::BigInt(int arr[]){
+  small=0;
+  spilled=false;
+  spill();
+  for(int i=29;i>=0;i--)
+    muladd(1000000000,arr[i]);
+  normalize();
 }
 
-BigInt::BigInt( const BigInt& rhs ){
-  size=rhs.size;
-  base=rhs.base;
-  for(int i=0;i<size;i++)
-    number[i]=rhs.number[i];
+// Into 30 decimal limbs of base 10^9, least significant first
+void BigInt::getArray( int arr[]){
+  BigInt t(*this);
+  for(int i=0;i<30;i++)
+    arr[i]=t.divmod(1000000000);
 }
 
-BigInt::BigInt(int arr[]){
-  size=30;
-  unsigned max=~0; 
-  base=1;
-  while(base*10<max)
-    base*=10;
-  for(int i=0;i<size;i++)
-    number[i]=arr[i];
-  
+// Moves the value from small into the limbs
+void BigInt::spill(){
+  if(spilled)
+    return;
+  limb[0]=(uint64_t)small;
+  limb[1]=(uint64_t)(small>>64);
+  for(int i=2;i<LIMBS;i++)
+    limb[i]=0;
+  spilled=true;
 }
-void BigInt::getArray( int arr[]){
-  for(int i=0;i<size;i++)
-    arr[i]=number[i];
-}
-
-const BigInt &BigInt::operator=(const BigInt & rhs){
-    for( int i= 0; i<size; i++ )
-      number[i] = rhs.number[i];
-    return *this;  
-}
-  
-BigInt BigInt::operator+=( BigInt& rhs){
-  unsigned long long carry=0;
-  for(int i=0;i<size;i++){
-    unsigned long long sum = number[i]+rhs.number[i]+carry;
-    if(sum >= base){
-      unsigned long long rem = sum%base; 
-      number[i] = rem;
-      carry=sum/base;
-    }
-    else{
-      number[i]+= rhs.number[i]+carry;
-      carry=0;
-    }  
-  }   
+
+// Moves the value back into small, if it fits there again
+void BigInt::normalize(){
+  if(!spilled)
+    return;
+  for(int i=2;i<LIMBS;i++)
+    if(limb[i]!=0)
+      return;
+  small=((unsigned __int128)limb[1]<<64)|limb[0];
+  spilled=false;
+}
+
+void BigInt::getLimbs( uint64_t out[]) const{
+  if(spilled){
+    for(int i=0;i<LIMBS;i++)
+      out[i]=limb[i];
+    return;
+  }
+  out[0]=(uint64_t)small;
+  out[1]=(uint64_t)(small>>64);
+  for(int i=2;i<LIMBS;i++)
+    out[i]=0;
+}
+
+BigInt &BigInt::operator+=( const BigInt& rhs){
+  unsigned __int128 sum;
+  if(!spilled && !rhs.spilled
+      && !__builtin_add_overflow(small,rhs.small,&sum)){
+    small=sum;
+    return *this;
+  }
+  uint64_t r[LIMBS];
+  rhs.getLimbs(r);
+  spill();
+  unsigned char carry=0;
+  for(int i=0;i<LIMBS;i++)
+    carry=_addcarry_u64(carry,limb[i],r[i],(unsigned long long*)&limb[i]);
+  normalize();                              //In case it wrapped
   return *this;
 }
-BigInt BigInt::operator+=( unsigned long long rhs){
-  BigInt t(rhs);
-  (*this)+=t;
+
+// The slow path of adding a machine integer: small overflowed, or had already
+BigInt &BigInt::addlimbs( unsigned long long rhs){
+  spill();
+  unsigned char carry=_addcarry_u64(0,limb[0],rhs,(unsigned long long*)&limb[0]);
+  for(int i=1;i<LIMBS && carry;i++)
+    carry=_addcarry_u64(carry,limb[i],0,(unsigned long long*)&limb[i]);
+  normalize();
   return *this;
-} 
+}
 
-bool BigInt::operator==( const BigInt & r) const{
-  for(int i=0;i<size;i++)
-    if(number[i]!=r.number[i]) 
-      return false;
+// limb = limb*m + a
+void BigInt::muladd( uint32_t m, uint32_t a){
+  unsigned __int128 carry=a;
+  for(int i=0;i<LIMBS;i++){
+    carry+=(unsigned __int128)limb[i]*m;
+    limb[i]=(uint64_t)carry;
+    carry>>=64;
+  }
+}
+
+BigInt &BigInt::operator*=( const BigInt& rhs){
+  unsigned __int128 prod;
+  if(!spilled && !rhs.spilled
+      && !__builtin_mul_overflow(small,rhs.small,&prod)){
+    small=prod;
+    return *this;
+  }
+  uint64_t a[LIMBS],b[LIMBS];
+  getLimbs(a);
+  rhs.getLimbs(b);
+  spill();
+  for(int i=0;i<LIMBS;i++)
+    limb[i]=0;
+  for(int i=0;i<LIMBS;i++){                 //Schoolbook, keeping the low LIMBS
+    if(a[i]==0)
+      continue;
+    unsigned __int128 carry=0;
+    for(int j=0;i+j<LIMBS;j++){
+      carry+=(unsigned __int128)a[i]*b[j]+limb[i+j];
+      limb[i+j]=(uint64_t)carry;
+      carry>>=64;
+    }
+  }
+  normalize();
+  return *this;
+}
+
+// Divides by d (nonzero), returning the remainder
+unsigned long long BigInt::divmod( unsigned long long d){
+  if(!spilled){
+    unsigned long long rem=(unsigned long long)(small%d);
+    small/=d;
+    return rem;
+  }
+  unsigned __int128 rem=0;
+  for(int i=LIMBS-1;i>=0;i--){
+    rem=(rem<<64)|limb[i];
+    limb[i]=(uint64_t)(rem/d);
+    rem%=d;
+  }
+  normalize();
+  return (unsigned long long)rem;
+}
+
+// The value as an unsigned long long, if it fits in one
+bool BigInt::getULL( unsigned long long& x) const{
+  if(spilled || (small>>64)!=0)
+    return false;
+  x=(unsigned long long)small;
   return true;
 }
 
-ostream &operator<<(ostream& out, BigInt& rhs){
-  int i=rhs.size-1;
-  while(i>0 && rhs.number[i]==0)
-    i--;
-  out<<rhs.number[i--];
-  
-  unsigned max=rhs.base-1;
-  int num_digits=0;
-  while(max/10 > 0 ){
-    num_digits++;
-    max/=10;
-  }  
-  for(;i>=0;i--){
-    out.setf( ios::right, ios::adjustfield );
-    out<<setw(num_digits+1)<<setfill('0')<<rhs.number[i];
-  }  
+// Sign of *this - r
+int BigInt::compare( const BigInt& r) const{
+  if(!spilled && !r.spilled)
+    return small<r.small ? -1 : (small>r.small ? 1 : 0);
+  if(spilled!=r.spilled)                    //Spilled values are the larger
+    return spilled ? 1 : -1;
+  for(int i=LIMBS-1;i>=0;i--)
+    if(limb[i]!=r.limb[i])
+      return limb[i]<r.limb[i] ? -1 : 1;
+  return 0;
+}
+
+bool BigInt::operator==( const BigInt & r) const{
+  return compare(r)==0;
+}
+
+const BigInt &bigfact( int k){
+  static const struct Table{
+    BigInt f[MAXFACT+1];
+    Table(){
+      f[0]=1;
+      for(int i=1;i<=MAXFACT;i++){
+        f[i]=f[i-1];
+        f[i]*=i;
+      }
+    }
+  } table;
+  if(k<0 || k>MAXFACT){
+    cerr<<"bigfact("<<k<<") is outside 0.."<<MAXFACT<<endl;
+    abort();
+  }
+  return table.f[k];
+}
+
+// In decimal, nine digits at a time from the least significant
+ostream &operator<<(ostream& out, const BigInt& rhs){
+  BigInt t(rhs);
+  uint32_t digits[33];
+  int i=0;
+  do
+    digits[i++]=(uint32_t)t.divmod(1000000000);
+  while(t.spilled || t.small!=0);
+
+  out<<digits[--i];
+  char fill=out.fill('0');
+  for(i--;i>=0;i--)
+    out<<setw(9)<<digits[i];
+  out.fill(fill);
   return out;
 }
+
+void BigAccum::merge( const BigAccum& r){
+  add(r.word);
+  high+=r.high;
+}
+
+BigInt BigAccum::value() const{
+  BigInt v(high);
+  v*=1ULL<<32;
+  v*=1ULL<<32;
+  v+=word;
+  return v;
+}
+
+// The sum as an unsigned __int128, if it fits in one
+bool BigAccum::get( unsigned __int128& x) const{
+  unsigned long long h;
+  if(!high.getULL(h))
+    return false;
+  x=((unsigned __int128)h<<64)|word;
+  return true;
+}
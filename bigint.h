@@ -4,25 +4,79 @@
 #include "stdafx.h"
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
 
 using namespace std;
 
+// Unsigned integers of up to 960 bits (the 270 decimal digits of the old
+// base 10^9 limbs). A value stays in a single unsigned __int128 until it
+// outgrows it, and only then spills into binary limbs, so adding machine
+// integers costs one 128-bit add in all but the rarest case. Conversion to
+// decimal happens only in operator<<. Products beyond 960 bits wrap, as
+// sums always have.
 class BigInt{
-  friend ostream &operator<<(ostream&,BigInt&);
-public: 
+  friend ostream &operator<<(ostream&,const BigInt&);
+public:
+  static const int LIMBS = 15;
   BigInt( unsigned long long = 0);
-  BigInt( const BigInt& rhs );
   BigInt( int[] );
   void getArray( int[] );
-  const BigInt &operator=(const BigInt &);
-  BigInt operator+=( BigInt&);
-  BigInt operator+=( unsigned long long );
+  BigInt &operator+=( const BigInt&);
+  BigInt &operator+=( unsigned long long rhs ){
+    unsigned __int128 sum;
+    if(!spilled && !__builtin_add_overflow(small,(unsigned __int128)rhs,&sum)){
+      small=sum;
+      return *this;
+    }
+    return addlimbs(rhs);
+  }
+  BigInt &operator*=( const BigInt&);
+  BigInt &operator*=( unsigned long long rhs ){ return (*this)*=BigInt(rhs); }
+  unsigned long long divmod( unsigned long long );
+  BigInt &operator/=( unsigned long long d ){ divmod(d); return *this; }
+  bool getULL( unsigned long long& ) const;
   bool operator==( const BigInt &) const;
-  bool operator!=( const BigInt & r ) const{ return !(*this==r); }   
-private:  
-  unsigned number[30];
-  int size;
-  unsigned long long base;
+  bool operator!=( const BigInt & r ) const{ return !(*this==r); }
+  bool operator<( const BigInt & r ) const{ return compare(r)<0; }
+  bool operator>( const BigInt & r ) const{ return compare(r)>0; }
+  bool operator<=( const BigInt & r ) const{ return compare(r)<=0; }
+  bool operator>=( const BigInt & r ) const{ return compare(r)>=0; }
+private:
+  unsigned __int128 small;          //The value, while it fits
+  bool spilled;                     //Whether it has outgrown small
+  uint64_t limb[LIMBS];             //Then the value, least significant first
+  void spill();
+  void getLimbs( uint64_t[] ) const;
+  BigInt &addlimbs( unsigned long long );
+  void normalize();
+  void muladd( uint32_t, uint32_t );
+  int compare( const BigInt& ) const;
 };
 
+// A running sum owned by one thread. Increments go into a native word, and
+// only when it wraps is a 2^64 carried into the BigInt high; merge adds up
+// the sums of several threads once they are done with them.
+class BigAccum{
+public:
+  BigAccum() : word(0) {}
+  void add( unsigned long long x ){
+    if(__builtin_add_overflow(word,x,&word))
+      high+=1ULL;
+  }
+  void add( unsigned __int128 x ){
+    add((unsigned long long)x);
+    high+=(unsigned long long)(x>>64);
+  }
+  void merge( const BigAccum& );
+  BigInt value() const;
+  bool get( unsigned __int128& ) const;
+private:
+  unsigned long long word;          //The sum mod 2^64
+  BigInt high;                      //  and the number of times it wrapped
+};
+
+// k! for k <= MAXFACT, from a table built on first use
+const int MAXFACT = 150;
+const BigInt &bigfact( int k );
+
 #endif
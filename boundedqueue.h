@@ -0,0 +1,75 @@
+// boundedqueue.h
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// A bounded-capacity wrapper around moodycamel::BlockingConcurrentQueue.
+// A semaphore counts the free slots: producers block in enqueue exactly
+// until a consumer has made room, so the queue depth never exceeds the
+// capacity and nobody has to poll its size.
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include "blockingconcurrentqueue.h"
+
+template<typename T>
+class BoundedQueue {
+	typedef moodycamel::details::mpmc_sema::LightweightSemaphore Semaphore;
+public:
+	explicit BoundedQueue(size_t capacity)
+		: slots((Semaphore::ssize_t) capacity), capacity(capacity) {}
+
+	// Tokens are made from the underlying queue
+	moodycamel::BlockingConcurrentQueue<T> q;
+
+	// Blocks until there is room for item
+	void enqueue(moodycamel::ProducerToken& tok, const T& item) {
+		slots.wait();
+		q.enqueue(tok, item);
+	}
+
+	// Blocks until there is room for all count items.
+	// The batches in flight at once must fit within the capacity.
+	template<typename It>
+	void enqueue_bulk(moodycamel::ProducerToken& tok, It first, size_t count) {
+		acquire(count);
+		q.enqueue_bulk(tok, first, count);
+	}
+	template<typename It>
+	void enqueue_bulk(It first, size_t count) {
+		acquire(count);
+		q.enqueue_bulk(first, count);
+	}
+
+	// Blocks until an item is available
+	void wait_dequeue(moodycamel::ConsumerToken& tok, T& item) {
+		q.wait_dequeue(tok, item);
+		slots.signal();
+	}
+
+	// Blocks until at least one item is available, then takes up to max
+	template<typename It>
+	size_t wait_dequeue_bulk(moodycamel::ConsumerToken& tok, It first, size_t max) {
+		size_t got = q.wait_dequeue_bulk(tok, first, max);
+		slots.signal((Semaphore::ssize_t) got);
+		return got;
+	}
+
+	// Blocks until every item enqueued so far has been dequeued.
+	// Only meaningful once the producers have stopped.
+	void drain() {
+		acquire(capacity);
+		slots.signal((Semaphore::ssize_t) capacity);
+	}
+
+private:
+	void acquire(size_t count) {
+		for (size_t got = 0; got < count; )
+			got += slots.waitMany((Semaphore::ssize_t) (count - got));
+	}
+
+	Semaphore slots;				// Free slots
+	size_t capacity;
+};
+
+#endif
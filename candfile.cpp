@@ -0,0 +1,272 @@
+// candfile.cpp
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// Reading and writing of candidate files, the hypercomplete functions passed
+// from GoldilocksEnumParallel.cpp to GoldilocksTestParallel.cpp.
+// Like functions.cpp, this expects n and tn to be defined before it is
+// included, and functions.cpp to be included first.
+
+// Candidate file format, version 1 (all integers little-endian):
+//   bytes  0-7   magic "GOLDCAND", or "GOLDPART" until the file is finished
+//   bytes  8-11  format version (1)
+//   bytes 12-15  n
+//   bytes 16-23  number of records
+//   bytes 24-31  checksum: sum of candhash() over all records, mod 2^64
+//   bytes 32-39  shard k of a sharded enumeration (zero if not sharded)
+//   bytes 40-47  number of shards N (zero if not sharded)
+//   bytes 48-63  reserved (zero)
+// followed by the records, each recwords 64-bit words, where bit b of word w
+// is F[64w + b]. For n < 6 a record is a single word with the high bits zero.
+// The checksum does not depend on the order of the records, so several
+// writers may share one file. A finished file is exactly as long as its
+// header and records; one left by an enumerator that was killed or is still
+// running keeps the "GOLDPART" header it was opened with.
+
+using namespace std;
+
+const unsigned candversion = 1;
+const unsigned recwords = (tn + 63)/64;			// 64-bit words per record
+const unsigned recbytes = 8*recwords;			// Bytes per record
+
+struct CandHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t n;
+	uint64_t count;
+	uint64_t checksum;
+	uint64_t shard, shards;
+	uint64_t reserved[2];
+};
+
+// Packs F into recwords 64-bit words, copied whole from the bitset's own
+// words (see words() in functions.cpp)
+void pack(const bitset<tn>& F, uint64_t w[]) {
+	memcpy(w, words(F), recbytes);
+}
+
+// Unpacks recwords 64-bit words into F
+void unpack(const uint64_t w[], bitset<tn>& F) {
+	memcpy((void*) &F, w, recbytes);
+	if (tn % 64 != 0)				// Keep the unused high bits zero (n < 6)
+		F &= ~bitset<tn>();
+}
+
+// Hash of len 64-bit words
+uint64_t hashwords(const uint64_t w[], int len) {
+	uint64_t h = 0x9E3779B97F4A7C15ULL;
+	for (int i = 0; i < len; i++) {
+		h ^= w[i];
+		h *= 0xBF58476D1CE4E5B9ULL;
+		h ^= h >> 31;
+	}
+	return h;
+}
+
+// Replaces the file name with the len words w. They go to a temporary file,
+// which is synced to disk before it is renamed over name, so a crash leaves
+// either the old file or the new one.
+bool savewords(const std::string& name, const uint64_t w[], size_t len) {
+	std::string tmpname = name + ".tmp";
+	int fd = ::open(tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+	const char* p = (const char*) w;
+	size_t left = 8*len;
+	while (left > 0) {
+		ssize_t put = ::write(fd, p, left);
+		if (put <= 0)
+			break;
+		p += put;
+		left -= put;
+	}
+	bool ok = left == 0 && ::fsync(fd) == 0;
+	ok = (::close(fd) == 0) && ok;
+	return ok && rename(tmpname.c_str(), name.c_str()) == 0;
+}
+
+// Hash of a single packed record, summed into the header checksum
+uint64_t candhash(const uint64_t w[]) {
+	return hashwords(w, recwords);
+}
+
+void writeheader(ofstream& outfile, bool finished, lint count, uint64_t checksum,
+		int shard = 0, int shards = 0) {
+	CandHeader h = CandHeader();
+	memcpy(h.magic, finished ? "GOLDCAND" : "GOLDPART", 8);
+	h.version = candversion;
+	h.n = n;
+	h.count = count;
+	h.checksum = checksum;
+	h.shard = shard;
+	h.shards = shards;
+	outfile.seekp(0);
+	outfile.write((char*) &h, sizeof(h));
+}
+
+// Checks the header of a candidate file against this n
+bool checkheader(const CandHeader& h, bool finished = true) {
+	return (memcmp(h.magic, finished ? "GOLDCAND" : "GOLDPART", 8) == 0)
+		&& (h.version == candversion) && (h.n == n);
+}
+
+// Length of a candidate file holding count records
+off_t candlength(lint count) {
+	return sizeof(CandHeader) + (off_t) count*recbytes;
+}
+
+// Parses a shard "k/N" with 0 <= k < N
+bool parseshard(const char* arg, int& shard, int& shards) {
+	return sscanf(arg, "%d/%d", &shard, &shards) == 2 && shards >= 1
+		&& shard >= 0 && shard < shards;
+}
+
+// Tags a file name with its shard, if the run is sharded
+std::string shardtag(int shard, int shards) {
+	if (shards <= 1)
+		return "";
+	return "_" + std::to_string(shard) + "of" + std::to_string(shards);
+}
+
+// A candidate file mapped read-only into memory
+struct CandMap {
+	CandHeader header;
+	const uint64_t* recs;			// First record
+	void* base;
+	size_t length;
+};
+
+// Maps a finished candidate file, checking that it holds exactly the records
+// its header claims
+bool mapcands(const char* name, CandMap& m) {
+	int fd = open(name, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(CandHeader)) {
+		close(fd);
+		return false;
+	}
+	m.length = st.st_size;
+	m.base = mmap(NULL, m.length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (m.base == MAP_FAILED)
+		return false;
+	madvise(m.base, m.length, MADV_SEQUENTIAL);
+
+	memcpy(&m.header, m.base, sizeof(CandHeader));
+	m.recs = (const uint64_t*) ((char*) m.base + sizeof(CandHeader));
+	if (!checkheader(m.header) || (off_t) m.length != candlength(m.header.count)) {
+		munmap(m.base, m.length);
+		return false;
+	}
+	return true;
+}
+
+void unmapcands(CandMap& m) {
+	munmap(m.base, m.length);
+}
+
+const int wbufsize = 2097152; 		// Write buffer size (in chars)
+									// 		Must be mult of recbytes,
+									//		smaller version 65536
+
+// Write buffer, one per worker thread
+struct WriteBuffer {
+	uint64_t buffer[wbufsize/8];
+	int bufi = 0; 					// Number of bitsets currently in buffer
+	lint count = 0;					// Number of bitsets written through it
+	uint64_t checksum = 0;
+};
+
+// Allows all workers to share the output file
+std::mutex wbufMut;
+
+// Buffered write of bitset data to file
+void write(ofstream& outfile, WriteBuffer& wb, bitset<tn>& F) {
+	static const int buflen = wbufsize/recbytes;
+	uint64_t* rec = wb.buffer + wb.bufi*recwords;
+	pack(F, rec);
+	wb.checksum += candhash(rec);
+	wb.count++;
+	wb.bufi++;
+
+	if (wb.bufi == buflen) { // Flush buffer
+		std::lock_guard<std::mutex> lock(wbufMut);
+		outfile.write((char*) wb.buffer, wbufsize);
+		wb.bufi = 0;
+	}
+}
+
+// Final flush of buffer
+void flush (ofstream& outfile, WriteBuffer& wb) {
+	std::lock_guard<std::mutex> lock(wbufMut);
+	outfile.write((char*) wb.buffer, wb.bufi*recbytes);
+	wb.bufi = 0;
+}
+
+// Opens a candidate file, with a header marking it unfinished until
+// closecands() replaces it
+bool opencands(ofstream& outfile, const char* name) {
+	outfile.open(name, ios::binary);
+	writeheader(outfile, false, 0, 0);
+	return (bool) outfile;
+}
+
+// Cuts an unfinished candidate file back to its first count records,
+// dropping anything written after them; false if it is not unfinished or
+// is shorter than that
+bool trimcands(const char* name, lint count) {
+	CandHeader h;
+	ifstream infile(name, ios::binary);
+	if (!infile.read((char*) &h, sizeof(h)) || !checkheader(h, false))
+		return false;
+	infile.close();
+	struct stat st;
+	return stat(name, &st) == 0 && st.st_size >= candlength(count)
+		&& truncate(name, candlength(count)) == 0;
+}
+
+// Sums candhash() over the records of a candidate file, which must hold
+// exactly count of them
+bool sumcands(const char* name, lint count, uint64_t& checksum) {
+	struct stat st;
+	if (stat(name, &st) != 0 || st.st_size != candlength(count))
+		return false;
+	ifstream infile(name, ios::binary);
+	if (!infile.seekg(sizeof(CandHeader)))
+		return false;
+	static const lint buflen = wbufsize/recbytes;
+	vector<uint64_t> buf(buflen*recwords);
+	checksum = 0;
+	for (lint done = 0; done < count; ) {
+		lint got = min(buflen, count - done);
+		if (!infile.read((char*) &buf[0], got*recbytes))
+			return false;
+		for (lint i = 0; i < got; i++)
+			checksum += candhash(&buf[i*recwords]);
+		done += got;
+	}
+	return true;
+}
+
+// Reopens an unfinished candidate file, once trimcands() has cut it back,
+// to append to it
+bool reopencands(ofstream& outfile, const char* name) {
+	outfile.open(name, ios::binary | ios::in | ios::out);
+	outfile.seekp(0, ios::end);
+	return (bool) outfile;
+}
+
+// Fills in the header once every buffer has been flushed
+void closecands(ofstream& outfile, WriteBuffer wbs[], int nbufs,
+		int shard = 0, int shards = 0) {
+	lint count = 0;
+	uint64_t checksum = 0;
+	for (int i = 0; i < nbufs; i++) {
+		count += wbs[i].count;
+		checksum += wbs[i].checksum;
+	}
+	writeheader(outfile, true, count, checksum, shard, shards);
+	outfile.close();
+}
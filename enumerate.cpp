@@ -0,0 +1,311 @@
+// enumerate.cpp
+// by Nicolle Gruzling
+// Adapted by Connor Halleck-Dube as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// Parallel generation of the hypercomplete boolean functions on n variables,
+// shared by GoldilocksEnumParallel.cpp (which writes them to file) and
+// GoldilocksTestParallel.cpp (which can test them as they are generated).
+// Like functions.cpp, this expects n, tn and the Great/Less tables to be
+// defined before it is included.
+
+// Every function generated is closed upward under lessdot, and so is already
+// the S_n-canonical member of its orbit, with non-decreasing Chow parameters:
+// moving a 1 from bit k to an empty bit k+1 stays inside F, which maps the
+// points of F with only bit k of the two set one-to-one into those with only
+// bit k+1 set, so a[k] <= a[k+1]. No branch of the DFS can lead outside the
+// canonical form, so there is nothing for a symmetry test to cut.
+
+// R. O. Winder. Enumeration of seven-argument threshold functions.
+// 		IEEE Transactions on Electronic Computers, EC-14(3):315–325, 1965.
+
+using namespace std;
+
+bitset<tn> lessa[tn];				// lessa[i] = all elements not below i
+
+// Built up from the points each one covers, which are all smaller than it:
+// everything below i is i and everything below them.
+void initless(bitset<tn> less[]){
+	const CoverMasks& cm = covermasks();
+	for(unsigned i=0;i<tn;i++){
+		bitset<tn> below;
+		below.set(i);
+		for(unsigned c=0;c<n;c++)
+			if(i>=cm.shift[c] && cm.cover[c].test(i-cm.shift[c]))
+				below |= ~less[i-cm.shift[c]];
+		less[i] = ~below;
+	}
+}
+
+// A node of the DFS tree: the subtree of all hypercomplete functions
+// containing F and built from the elements of free.
+struct Frame {
+	bitset<tn> F, free;
+};
+
+// The subtree of (F, free) containing j, its largest free element
+Frame child(const bitset<tn>& F, const bitset<tn>& free, unsigned j) {
+	Frame in;
+	in.F = F; in.F.set(j);
+	in.free = free; in.free.reset(j);
+	if(posn(j,n-1) && posn(j,n-2) ){
+		unsigned z = comp(n-2,j); set(z,n-1);
+		in.free &= lessa[z];
+	}
+	return in;
+}
+
+// A subtree made by splittree, by the size of its free set and the order
+// in which it was made. The one with the most free elements, and of those
+// the earliest made, comes out of a priority_queue first.
+struct Leaf {
+	size_t count, id;
+	bool operator<(const Leaf& o) const {
+		return count < o.count || (count == o.count && id > o.id);
+	}
+};
+
+// Splits the whole tree into at least target subtrees (fewer if it runs
+// out of nodes to split), always splitting the subtree with the most free
+// elements, as the likeliest to be the largest. The functions at the nodes
+// split go to inner and the subtrees left to leaves, in an order that
+// depends only on n, so separate processes agree on it.
+void splittree(size_t target, vector<Frame>& leaves, vector<bitset<tn>>& inner) {
+	vector<Frame> made(1);				// Every subtree, by id
+	made[0].F.reset(); made[0].free.set();
+	std::priority_queue<Leaf> queue;
+	queue.push(Leaf{tn, 0});
+	while (queue.size() < target && queue.top().count > 0) {
+		size_t big = queue.top().id;
+		queue.pop();
+		bitset<tn> F = made[big].F;
+		bitset<tn> free = made[big].free;
+		inner.push_back(F);
+		while (free.any()) {
+			unsigned j = tn-1;
+			while(!free.test(j))
+				j--;
+			made.push_back(child(F, free, j));
+			queue.push(Leaf{made.back().free.count(), made.size()-1});
+			free &= lessa[j];
+		}
+	}
+
+	// The leaves in the order they were made
+	vector<size_t> ids;
+	for (; !queue.empty(); queue.pop())
+		ids.push_back(queue.top().id);
+	std::sort(ids.begin(), ids.end());
+	leaves.clear();
+	for (size_t i = 0; i < ids.size(); i++)
+		leaves.push_back(made[ids[i]]);
+}
+
+// Work-stealing pool. Each worker runs the DFS on a private stack; while
+// more workers are hungry than there are subtrees waiting for them, it
+// donates the bottom (oldest, hence largest) subtree of its stack to its
+// shared deque, where any idle worker can take it. Idle workers sleep on
+// idleCV until a subtree is donated, the work runs out or a checkpoint
+// is due.
+struct Worker {
+	std::mutex mut;
+	std::deque<Frame> shared;			// Subtrees available for stealing
+	lint tcount = 0;					// Number generated by this worker
+	lint stolen = 0;					// Number of subtrees taken from others
+};
+Worker* workers;
+int numworkers;
+
+std::atomic<int> hungry(0);			// Number of idle workers waiting for work
+std::atomic<int> available(0);		// Subtrees in shared deques
+std::atomic<lint> work(0);			// Subtrees in shared deques + busy workers
+std::mutex idleMut;
+std::condition_variable idleCV;
+
+// Wakes idle workers after available, work or pausing has changed. Taking
+// idleMut orders the change before any check made under it, so no wake-up
+// is lost between a worker's check and its wait.
+void wakeidle(bool all) {
+	{ std::lock_guard<std::mutex> lock(idleMut); }
+	if (all)
+		idleCV.notify_all();
+	else
+		idleCV.notify_one();
+}
+
+// Checkpointing. While pausing is set, each worker stops at its next safe
+// point, where every subtree it has left to do is on its stack, calls
+// finish and waits; the whole state of the DFS is then the parked stacks
+// and the shared deques.
+std::atomic<bool> pausing(false);
+std::mutex pauseMut;
+std::condition_variable pauseCV;
+int running = 0;					// Workers not yet out of work
+int parked = 0;
+vector<Frame>** stacks;				// Each worker's stack, for the checkpoint
+
+void park(int id, void (*finish)(int)) {
+	finish(id);
+	std::unique_lock<std::mutex> lock(pauseMut);
+	parked++;
+	pauseCV.notify_all();
+	pauseCV.wait(lock, []{ return !pausing.load(); });
+	parked--;
+}
+
+// Takes a subtree from the shared deques, starting with the worker's own
+bool steal(int id, Frame& fr) {
+	if (available.load() == 0)
+		return false;
+	for (int k = 0; k < numworkers; k++) {
+		int v = (id + k) % numworkers;
+		std::lock_guard<std::mutex> lock(workers[v].mut);
+		if (!workers[v].shared.empty()) {
+			fr = workers[v].shared.front();
+			workers[v].shared.pop_front();
+			available--;
+			if (v != id)
+				workers[id].stolen++;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Thread function: enumerates hypercomplete functions until no work is left,
+// passing each one to emit. Calls finish once the pool has run dry.
+void enumerator(int id, void (*emit)(int, bitset<tn>&), void (*finish)(int)) {
+	Worker& me = workers[id];
+	vector<Frame> stk;           			// A stack to hold fcns to process
+	stacks[id] = &stk;
+	Frame fr;
+
+	while (true) {
+		// Out of work: wait for a subtree to appear in some shared deque
+		hungry++;
+		while (!steal(id, fr)) {
+			if (work.load() == 0) {
+				hungry--;
+				finish(id);
+				std::lock_guard<std::mutex> lock(pauseMut);
+				stacks[id] = NULL;
+				running--;
+				pauseCV.notify_all();
+				return;
+			}
+			if (pausing.load()) {
+				park(id, finish);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(idleMut);
+			idleCV.wait(lock, []{ return available.load() > 0 || work.load() == 0
+				|| pausing.load(); });
+		}
+		hungry--;
+		stk.push_back(fr);
+
+		while (!stk.empty()) {
+			if (pausing.load(std::memory_order_relaxed))
+				park(id, finish);
+
+			bitset<tn> F = stk.back().F;		//Pop the top set and its free
+			bitset<tn> free = stk.back().free;	//variables off the stack.
+			stk.pop_back();
+
+			while (free.count() > 0) {
+				unsigned j = tn-1;         		//Find the largest free element.
+				while(!free.test(j))
+					j--;
+
+				stk.push_back(child(F, free, j));	//Push the subtree containing j.
+
+				free &= lessa[j];         		//Remove elements less than j.
+
+				// Hand the largest pending subtree to a hungry worker
+				if (stk.size() > 1 && hungry.load(std::memory_order_relaxed)
+						> available.load(std::memory_order_relaxed)) {
+					{
+						std::lock_guard<std::mutex> lock(me.mut);
+						me.shared.push_back(stk.front());
+						work++;
+						available++;
+					}
+					stk.erase(stk.begin());
+					wakeidle(false);
+				}
+			}
+			me.tcount++;
+			emit(id, F);
+		}
+		if (--work == 0)
+			wakeidle(true);
+	}
+}
+
+// Enumerates all hypercomplete functions on nthreads workers.
+// Requires initless(lessa). Returns the number generated.
+// If start is given, enumerates only its subtrees, which were left over
+// from a run that had already generated tcount functions. Every every
+// seconds (if every > 0), the workers pause and save is passed the
+// subtrees left to do and the number generated so far.
+lint enumerate(int nthreads, void (*emit)(int, bitset<tn>&), void (*finish)(int),
+		lint& stolen, const vector<Frame>* start = NULL, lint tcount = 0,
+		int every = 0, void (*save)(const vector<Frame>&, lint) = NULL) {
+	numworkers = nthreads;
+	workers = new Worker[numworkers];
+	stacks = new vector<Frame>*[numworkers]();
+
+	if (start == NULL) {		// Seed the pool with the whole tree
+		Frame root;
+		root.F.reset(); root.free.set();
+		workers[0].shared.push_back(root);
+		work = 1;
+	}
+	else {						// Or with what was left of it
+		for (size_t i = 0; i < start->size(); i++)
+			workers[i % numworkers].shared.push_back((*start)[i]);
+		work = start->size();
+	}
+	available = work.load();
+	hungry = 0;
+	workers[0].tcount = tcount;
+	running = numworkers;
+
+	std::thread thdary[numworkers];
+	for (int i = 0; i < numworkers; i++)
+		thdary[i] = std::thread(enumerator, i, emit, finish);
+
+	// Checkpoint every so often until the workers run out of work
+	std::unique_lock<std::mutex> lock(pauseMut);
+	while (every > 0 && !pauseCV.wait_for(lock, std::chrono::seconds(every),
+			[]{ return running == 0; })) {
+		pausing = true;
+		wakeidle(true);
+		pauseCV.wait(lock, []{ return parked == running; });
+
+		vector<Frame> left;
+		lint count = 0;
+		for (int i = 0; i < numworkers; i++) {
+			if (stacks[i] != NULL)
+				left.insert(left.end(), stacks[i]->begin(), stacks[i]->end());
+			left.insert(left.end(), workers[i].shared.begin(), workers[i].shared.end());
+			count += workers[i].tcount;
+		}
+		save(left, count);
+
+		pausing = false;
+		pauseCV.notify_all();
+	}
+	lock.unlock();
+
+	tcount = 0;
+	stolen = 0;
+	for (int i = 0; i < numworkers; i++) {
+		thdary[i].join();
+		tcount += workers[i].tcount;
+		stolen += workers[i].stolen;
+	}
+	delete[] stacks;
+	delete[] workers;
+	return tcount;
+}
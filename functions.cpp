@@ -11,57 +11,164 @@
 
 using namespace std;
 
+// posmask[j] = the points with bit j set
+struct PosMasks {
+  bitset<tn> m[n];
+  PosMasks(){
+    for(unsigned j=0;j<n;j++)
+      for(unsigned i=0;i<tn;i++)
+        if(posn(i,j))
+          m[j].set(i);
+  }
+};
+const bitset<tn>* posmask(){
+  static const PosMasks masks;
+  return masks.m;
+}
+
+// The 64-bit words of a bitset, as libstdc++ lays them out
+const unsigned tnwords = (tn+63)/64;
+static_assert(sizeof(bitset<tn>)==8*tnwords, "bitset<tn> is not tnwords words");
+inline const uint64_t* words(const bitset<tn>& F){
+  return reinterpret_cast<const uint64_t*>(&F);
+}
+
+// Popcount kernels: c[j] = |F & posmask[j]| for j<n, and c[n] = |F|,
+// given the words f of F. chowcount points at the best one for this CPU.
+typedef void (*ChowCount)(const uint64_t* f, int c[]);
+
+__attribute__((always_inline))
+inline void chowcount_words(const uint64_t* f, int c[]){
+  const bitset<tn>* mask = posmask();
+  for(unsigned j=0;j<n;j++){
+    const uint64_t* m = words(mask[j]);
+    int t = 0;
+    for(unsigned w=0;w<tnwords;w++)
+      t += __builtin_popcountll(f[w]&m[w]);
+    c[j] = t;
+  }
+  int t = 0;
+  for(unsigned w=0;w<tnwords;w++)
+    t += __builtin_popcountll(f[w]);
+  c[n] = t;
+}
+void chowcount_scalar(const uint64_t* f, int c[]){
+  chowcount_words(f,c);
+}
+__attribute__((target("popcnt")))
+void chowcount_popcnt(const uint64_t* f, int c[]){
+  chowcount_words(f,c);
+}
+
+// Four words at a time, counting each byte by nibble lookups
+__attribute__((target("avx2,popcnt")))
+void chowcount_avx2(const uint64_t* f, int c[]){
+  const bitset<tn>* mask = posmask();
+  const __m256i lut = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                       0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  const unsigned vw = tnwords - tnwords%4;
+  for(unsigned j=0;j<=n;j++){
+    const uint64_t* m = (j<n) ? words(mask[j]) : 0;
+    __m256i acc = _mm256_setzero_si256();
+    for(unsigned w=0;w<vw;w+=4){
+      __m256i v = _mm256_loadu_si256((const __m256i*)(f+w));
+      if(m)
+        v = _mm256_and_si256(v,_mm256_loadu_si256((const __m256i*)(m+w)));
+      __m256i lo = _mm256_and_si256(v,nibble);
+      __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v,4),nibble);
+      __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lut,lo),
+                                      _mm256_shuffle_epi8(lut,hi));
+      acc = _mm256_add_epi64(acc,_mm256_sad_epu8(bytes,_mm256_setzero_si256()));
+    }
+    int t = _mm256_extract_epi64(acc,0) + _mm256_extract_epi64(acc,1)
+          + _mm256_extract_epi64(acc,2) + _mm256_extract_epi64(acc,3);
+    for(unsigned w=vw;w<tnwords;w++)
+      t += __builtin_popcountll(m ? f[w]&m[w] : f[w]);
+    c[j] = t;
+  }
+}
+
+// Eight words at a time with VPOPCNTQ, masking off the words past tnwords
+__attribute__((target("avx512f,avx512vpopcntdq")))
+void chowcount_vpopcnt(const uint64_t* f, int c[]){
+  const bitset<tn>* mask = posmask();
+  for(unsigned j=0;j<=n;j++){
+    const uint64_t* m = (j<n) ? words(mask[j]) : 0;
+    __m512i acc = _mm512_setzero_si512();
+    for(unsigned w=0;w<tnwords;w+=8){
+      __mmask8 k = (tnwords-w>=8) ? 0xff : (1<<(tnwords-w))-1;
+      __m512i v = _mm512_maskz_loadu_epi64(k,f+w);
+      if(m)
+        v = _mm512_and_si512(v,_mm512_maskz_loadu_epi64(k,m+w));
+      acc = _mm512_add_epi64(acc,_mm512_popcnt_epi64(v));
+    }
+    uint64_t lanes[8];
+    _mm512_storeu_si512(lanes,acc);
+    c[j] = lanes[0]+lanes[1]+lanes[2]+lanes[3]+lanes[4]+lanes[5]+lanes[6]+lanes[7];
+  }
+}
+
+// The vector kernels only pay for themselves on a full register of words
+ChowCount pickchowcount(){
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512vpopcntdq") && tnwords>=8)
+    return chowcount_vpopcnt;
+  if(__builtin_cpu_supports("avx2") && tnwords>=4)
+    return chowcount_avx2;
+  if(__builtin_cpu_supports("popcnt"))
+    return chowcount_popcnt;
+  return chowcount_scalar;
+}
+ChowCount chowcount = pickchowcount();
+
 // Compute various Chow parameters of boolean function F
 void chowa(const bitset<tn>& F, int a[]){
-  for(int i=0;i<n;i++)
-    a[i]=0;
-    
-  for(int i=0;i<tn;i++){
-    if(F.test(i)){
-      for(int j=0;j<n;j++){
-        a[j]+=posn(i,j);
-      }
-    }
-  }  
-  return;
+  int c[n+1]; chowcount(words(F),c);
+  for(unsigned j=0;j<n;j++)
+    a[j]=c[j];
 }
 void chowav(const bitset<tn>& F, vector<int>& a){
-  for(int i=0;i<n;i++)
-    a.push_back(0);
-    
-  for(int i=0;i<tn;i++){
-    if(F.test(i)){
-      for(int j=0;j<n;j++){
-        a[j]+=posn(i,j);
-      }
-    }
-  }  
-  return;
+  int c[n+1]; chowcount(words(F),c);
+  for(unsigned j=0;j<n;j++)
+    a.push_back(c[j]);
 }
+// Chow parameters of the self-dualization of F (halved): the points of F
+// with bit j set, plus the points outside F with bit j clear
 void chowdualup(const bitset<tn>& F, int a[]){
-  for(int i=0;i<=n;i++)
-    a[i]=0;
-    
-  for(int i=0;i<tn;i++){
-    if(F.test(i)){
-      for(int j=0;j<n;j++){
-        a[j]+=posn(i,j);
+  int c[n+1]; chowcount(words(F),c);
+  for(unsigned j=0;j<n;j++)
+    a[j]=2*c[j]+tn/2-c[n];
+  a[n]=tn-c[n];
+}
+
+// k! for k <= n+1 as machine integers, taken once from the exact BigInt
+// table. On the way the largest orbit counted, (n+1)!*2tn in repsdualup,
+// is checked to fit in a lint, so the orbit sizes built from these are exact.
+const lint* facts(){
+  static const struct Table{
+    lint f[n+2];
+    Table(){
+      BigInt most = bigfact(n+1);
+      most *= 2*tn;
+      unsigned long long x;
+      if(!most.getULL(x) || x>LLONG_MAX){
+        cerr<<"Orbit sizes do not fit in 64 bits at n="<<n<<endl;
+        abort();
       }
-    }
-    else{
-      int h=comp(n+1,i);
-      for(int j=0;j<=n;j++){
-        a[j]+=posn(h,j);
+      for(unsigned k=0;k<=n+1;k++){
+        bigfact(k).getULL(x);
+        f[k]=x;
       }
     }
-  }  
-  return;
+  } table;
+  return table.f;
 }
 
 // Compute the number of boolean functions which can be reached from F
 // by permutation and complementation of any arguments of F
 lint reps(const bitset<tn>& F, int m){
-  static lint max = fact(n)*tn;
+  static lint max = facts()[n]*tn;
   lint rep = max;
   int a[n]; chowa(F,a);
   bool even = m%2==0;
@@ -75,18 +182,18 @@ lint reps(const bitset<tn>& F, int m){
       pcount++;
     }  
     else{
-      rep/=fact(pcount);
+      rep/=facts()[pcount];
       pcount=1; 
     }   
   }
-  rep/=fact(pcount);
+  rep/=facts()[pcount];
   return rep;      
 }
 // Compute the number of boolean functions which can be reached from F
 // by permutation, complementation, or self-dualization or anti-self-dualization
 lint repsdualup(const bitset<tn>& F){
   int m=tn;
-  static lint max = fact(n+1)*tn*2;
+  static lint max = facts()[n+1]*tn*2;
   lint rep = max;
   int a[n+1]; chowdualup(F,a);
   int pcount = 1;
@@ -99,17 +206,17 @@ lint repsdualup(const bitset<tn>& F){
       pcount++;
     }  
     else{
-      rep/=fact(pcount);
+      rep/=facts()[pcount];
       pcount=1; 
     }   
   }
-  rep/=fact(pcount);
+  rep/=facts()[pcount];
   return rep;      
 }
 
 //Returns true if i (assumed in F) is a border point of F.
 bool isinborder(unsigned i,const bitset<tn>& F){ 
-  for(int j=0;j<n;j++){                     
+  for(unsigned j=0;j<n;j++){                     
     unsigned less=i;
     if(posn(i,j)==1){
       set(less,j,0);
@@ -121,7 +228,7 @@ bool isinborder(unsigned i,const bitset<tn>& F){
 }
 //Returns true if i (assumed not in F) is a border point of F.
 bool isoutborder(unsigned i,const bitset<tn>& F){ 
-  for(int j=0;j<n;j++){                        
+  for(unsigned j=0;j<n;j++){                        
     unsigned great=i;
     if(posn(i,j)==0){
       set(great,j,1);
@@ -134,298 +241,495 @@ bool isoutborder(unsigned i,const bitset<tn>& F){
 
 //Returns true if i (assumed in F) is a boundary point of F.
 bool ishighbound(int i, const bitset<tn>& F){ 
-  for(int j=0;j<less[i].size();j++)           
-    if( F.test( less[i][j] ) )
+  for(unsigned j=0;j<Less[i].size();j++)           
+    if( F.test( Less[i][j] ) )
       return false;
   return true;
 }
 //Returns true if i (assumed not in F) is a boundary point of F.
 bool islowbound(int i, const bitset<tn>& F){  
-  for(int j=0;j<great[i].size();j++)         
-    if( !F.test( great[i][j] ) )
+  for(unsigned j=0;j<Great[i].size();j++)         
+    if( !F.test( Great[i][j] ) )
       return false;
   return true;
 }
 
-// Tests whether F is 2-monotonic
-bool ismonotonic(int an,int atn,const bitset<tn>& b){
-  bool val = 1;                               //In most cases we always testing
-                                              //sets that that have less 1's
-					      //than 0's.  
-  unsigned mask = 0;                          //We never care about the bits 
-  for(int i=0;i<an;i++)                       //greater than n, mask is used
-    set(mask,i,1);                            //make sure they are 0.
-    
-  unsigned h=an/2;  				
-    
-  for(unsigned m=0; m<atn; m++){              //m is used to find the different
-                                              //faces of the hypercube.
-					   
-    if(count(an,m,1)<=2 && count(an,m,1)<=h){
-    				      
-      for(unsigned i=0; i<atn; i++){
-        int icomp = (~(i^m))&mask;
-        if(b.test(i)==val && b.test(icomp)==val){//In the m face, if i and it's
-                                              //pair are in the set, then check
-					      //if another pair is not in the
-					      //set.
-					      
-	  for(unsigned k=0; k<icomp; k++ ){
-	    if( ((k&m)==(i&m)) &&             //Check k is in same face as i.
-	        b.test(k)!=val &&             //Check that k is in opposite set.
-	        b.test((~(k^m))&mask)!=val ){ //Check that the pair of k is in
-	                                      //the same set as k.
-	      return false;                   //If so b is not monotonic.
-	    }
-	  }
-        } 
+// F with every point x moved to x^c
+bitset<tn> flip(const bitset<tn>& F, unsigned c){
+  const bitset<tn>* mask = posmask();
+  bitset<tn> r = F;
+  for(unsigned j=0;j<n;j++)
+    if(posn(c,j))
+      r = ((r&mask[j]) >> (1<<j)) | ((r&~mask[j]) << (1<<j));
+  return r;
+}
+
+// True unless, in some face m of at most two (and at most n/2) fixed bits,
+// points i, i' of F and k, k' outside F agree on m, where x' is x with every
+// bit outside m flipped. Then i+i' = k+k', so F is not 2-summable and not
+// an LTF. P below holds the points whose partner x' is in F, so G = F&P
+// are the pairs in F and H the pairs outside it, and each face is a few
+// bitset shifts and tests rather than a search over pairs of points.
+bool ismonotonic(const bitset<tn>& F){
+  const bitset<tn>* mask = posmask();
+  const int h = n/2<2 ? n/2 : 2;
+
+  bitset<tn> P = flip(F,tn-1);                //m empty: x' is the complement
+  bitset<tn> G = F&P, H = ~(F|P);
+  if(G.any() && H.any())
+    return false;
+  if(h<1)
+    return true;
+
+  for(unsigned a=0;a<n;a++){
+    bitset<tn> Pa = flip(P,1<<a);             //Bit a kept
+    G = F&Pa; H = ~(F|Pa);
+    if(((G&mask[a]).any() && (H&mask[a]).any())
+        || ((G&~mask[a]).any() && (H&~mask[a]).any()))
+      return false;
+    if(h<2)
+      continue;
+
+    for(unsigned b=a+1;b<n;b++){
+      bitset<tn> Pab = flip(Pa,1<<b);         //Bits a and b kept
+      G = F&Pab; H = ~(F|Pab);
+      for(int p=0;p<4;p++){
+        bitset<tn> S = ((p&1) ? mask[a] : ~mask[a]) & ((p&2) ? mask[b] : ~mask[b]);
+        if((G&S).any() && (H&S).any())
+          return false;
       }
     }
   }
-  return true;                                //Innocent until proven guilty.
+  return true;
+}
+
+// How the LP decides separability: in double precision, exactly in integers,
+// or in double precision re-checked exactly whenever a decision was close
+enum SepMode { SEPFLOAT, SEPEXACT, SEPHYBRID };
+SepMode sepmode = SEPFLOAT;
+
+// Set by dual_simplex when a value it branched on was within lptol of zero
+thread_local bool lpdoubt = false;
+const double lptol = 0.000001;
+inline void checkdoubt(double x){
+  if(x!=0 && x<lptol && x>-lptol)
+    lpdoubt = true;
 }
+
 bool lexlesseq(double* b1,double* b2,int s){
   int i=0;
   while(i<s && (b1[i] - b2[i] == 0) )
     i++;
   if(i==s) 
     return true;
+  checkdoubt(b1[i]-b2[i]);
   if( b1[i]-b2[i] < 0)
     return true;
   return false;     
 }
 
+// Largest LP issep can build at this n: a constraint per point, n-1 rows
+// ordering the weights and an identity row per column
+const int lpcols = n+2;
+const int lprows = tn + n-1 + lpcols;
+
+// Per-thread storage for the LP, reused by every separability test
+struct LPArena {
+  double mat[lprows*lpcols];                  //Tableau, row-major
+  double cand[lpcols*lprows];                 //Scaled candidate pivot columns
+  int candcol[lpcols];                        //  and the columns they came from
+  double row[lpcols];                         //Copy of the pivot row
+  lint imat[lprows*lpcols];                   //Integer tableau for exact_simplex
+  lint irow[lpcols];
+};
+// Allocated on a thread's first LP, so threads that never run one (writers,
+// the reporter, enumerators) do not carry an arena for every n
+thread_local std::unique_ptr<LPArena> lparenaptr;
+inline LPArena& lparena(){
+  if(!lparenaptr)
+    lparenaptr.reset(new LPArena);
+  return *lparenaptr;
+}
+
 // Tests a linear inequality system mat for solution by the simplex method
+// mat holds p+q rows of q entries each, one row after another
 // True if a solution exists, false otherwise
-bool dual_simplex(double** mat,const int p,const int q, double* soln){
+bool dual_simplex(double* mat,const int p,const int q, double* soln){
+  const double e=0.000000001;
+  const int r = p+q;
+  LPArena& lp = lparena();
+  double* bs = lp.cand;
+  int* bp = lp.candcol;
+  double* b = lp.row;
 do{ 
-  static double e=0.000000001; 
   bool opt = true;
   int i=0;
-  for(;i<p+q;i++){
-    if(mat[i][0]<0){
+  for(;i<r;i++){
+    checkdoubt(mat[i*q]);
+    if(mat[i*q]<0){
       opt = false;
       break;
     }
   }
   if(opt){
-    soln[0] = mat[0][0];
+    soln[0] = mat[0];
     for(int k=1;k<q;k++){
-      soln[k] = mat[p+k][0];
+      soln[k] = mat[(p+k)*q];
     }
     return true;
   }
   else{
-    bool issoln = false;
-    for(int j=1;j<q;j++){
-      if(mat[i][j]>e){
-        issoln = true;
-        break;
-      }
-    }
-    if(!issoln)
-      return false;
-    
-    vector<double*> bs; vector<int> bp;
+    double* mi = mat + i*q;
+    int nb = 0;
     for(int j=1; j<q; j++){
-      if(mat[i][j]>e){
-        double* b = new double[p+q];
-	for(int k=0;k<p+q;k++){
-	  b[k]=mat[k][j]/mat[i][j];
+      checkdoubt(mi[j]);
+      if(mi[j]>e){
+        double* c = bs + nb*r;
+	for(int k=0;k<r;k++){
+	  c[k]=mat[k*q+j]/mi[j];
 	}  
-	bs.push_back(b);
-	bp.push_back(j);
+	bp[nb++] = j;
       }
     }
-    int j;
-    for(int k=0;k<bs.size();k++){
+    if(nb==0)
+      return false;
+
+    int j=bp[0];
+    for(int k=0;k<nb;k++){
       bool isless = true;
-      for(int l=0;l<bs.size();l++){
-        if(!lexlesseq(bs[k],bs[l],p+q)){
+      for(int l=0;l<nb;l++){
+        if(!lexlesseq(bs+k*r,bs+l*r,r)){
 	  isless = false;
 	}  
       }
       if(isless){
         j=bp[k];
-	for(int m=0;m<p+q;m++){
-	  mat[m][j]=bs[k][m];
+	for(int m=0;m<r;m++){
+	  mat[m*q+j]=bs[k*r+m];
 	}
         break;
       }
     }
     
-    for(int k=0;k<bs.size();k++)
-      delete bs[k];
-    
-    double b[p+q];
-    for(int k=0;k<p+q;k++)
-      b[k]=mat[i][k];
+    for(int k=0;k<q;k++)
+      b[k]=mi[k];
     
     for(int l=0;l<q;l++)
       if(l!=j)
-        for(int k=0;k<p+q;k++)
-          mat[k][l]= mat[k][l] - b[l]*mat[k][j];
+        for(int k=0;k<r;k++)
+          mat[k*q+l]= mat[k*q+l] - b[l]*mat[k*q+j];
     
   }
 }while(true);  
 }
 
+// The same method in exact arithmetic, by fraction-free (integer) pivoting.
+// The true tableau is mat/d; every pivot divides exactly by the previous
+// one, so the entries stay integers. Products are formed in 128 bits.
+// Returns 1 if a solution exists, 0 if not, -1 if an entry overflowed (or,
+// which should not happen, a division was inexact).
+int exact_simplex(lint* mat,const int p,const int q, double* soln){
+  const int r = p+q;
+  lint d = 1;                                 //Common denominator, always > 0
+  lint* b = lparena().irow;
+do{ 
+  int i=0;
+  while(i<r && mat[i*q]>=0)
+    i++;
+  if(i==r){
+    soln[0] = static_cast<double>(mat[0])/d;
+    for(int k=1;k<q;k++){
+      soln[k] = static_cast<double>(mat[(p+k)*q])/d;
+    }
+    return 1;
+  }
+
+  lint* mi = mat + i*q;
+  int j=0;                                    //Lexicographically least column
+  for(int l=1;l<q;l++){                       //  scaled by its pivot
+    if(mi[l]<=0)
+      continue;
+    if(j==0){
+      j=l;
+      continue;
+    }
+    for(int k=0;k<r;k++){
+      __int128 x = (__int128)mat[k*q+l]*mi[j], y = (__int128)mat[k*q+j]*mi[l];
+      if(x!=y){
+        if(x<y)
+          j=l;
+        break;
+      }
+    }
+  }
+  if(j==0)
+    return 0;
+
+  for(int k=0;k<q;k++)
+    b[k]=mi[k];
+  lint a = b[j];
+  for(int k=0;k<r;k++){
+    lint* mk = mat + k*q;
+    for(int l=0;l<q;l++){
+      if(l==j)
+        continue;
+      __int128 x = (__int128)mk[l]*a - (__int128)b[l]*mk[j];
+      if(x%d != 0)
+        return -1;
+      x /= d;
+      if(x>LLONG_MAX || x<LLONG_MIN)
+        return -1;
+      mk[l] = static_cast<lint>(x);
+    }
+  }
+  d = a;
+}while(true);
+}
+
+// The covering relation of the order used by Less and Great: y covers x when
+// y = x+shift[c] and x lies in cover[c]. Either bit 0 of x is clear and
+// y sets it (c = 0), or a 1 moves from bit c-1 to an empty bit c.
+struct CoverMasks {
+  bitset<tn> cover[n];
+  unsigned shift[n];
+  CoverMasks(){
+    const bitset<tn>* mask = posmask();
+    cover[0] = ~mask[0];
+    shift[0] = 1;
+    for(unsigned c=1;c<n;c++){
+      cover[c] = mask[c-1]&~mask[c];
+      shift[c] = 1<<(c-1);
+    }
+  }
+};
+
+const CoverMasks& covermasks(){
+  static const CoverMasks cm;
+  return cm;
+}
+
 // Initializes the "Less" and "Great" arrays
-// They encode a partial order relationship between vectors in {0, 1}^n
+// They encode a partial order relationship between vectors in {0, 1}^n:
+// Great[i] holds the points covering i, in increasing order, and Less[i]
+// the points i covers, in decreasing order, read off the cover masks.
 // R. O. Winder. Enumeration of seven-argument threshold functions. 
 //       IEEE Transactions on Electronic Computers, EC-14(3):315–325, 1965.
 void lessgreatinit(vector<int> great[], vector<int> less[]){	
-  for(int i=0;i<tn;i++){
-    for(int j=i+1;j<tn;j++){
-      if(  lessdot(n,i,j) ){
-        bool tightest = true;
-        for(int k=0;k<great[i].size();k++){
-	  if( lessdot( n,(great[i])[k],j) ){
-	    tightest=false;
-	  }
-	}
-	if(tightest){
-	  great[i].push_back(j);
-	}
-      }
-    }
-    for(int j=i-1;j>=0;j--){
-      if( lessdot(n,j,i) ){
-        bool tightest = true;
-        for(int k=0;k<less[i].size();k++){
-	  if( lessdot( n,j,less[i][k]) ){
-	    tightest=false;
-	  }
-	}
-	if(tightest){
-	  less[i].push_back(j);
-	}
-      }
+  const CoverMasks& cm = covermasks();
+  for(unsigned i=0;i<tn;i++){
+    great[i].clear();
+    less[i].clear();
+  }
+  for(unsigned c=0;c<n;c++){
+    const bitset<tn>& from = cm.cover[c];
+    for(unsigned i=from._Find_first();i<tn;i=from._Find_next(i)){
+      great[i].push_back(i+cm.shift[c]);
+      less[i+cm.shift[c]].push_back(i);
     }
-  }    
+  }
 }
 
-// Tests whether a boolean function F is a linear threshold function
-bool issep(bitset<tn>& F){
-  vector< vector<int> > constraints;
-  for(int i=0;i<tn;i++){
-    if(F.test(i)){
-      if(ishighbound(i,F)){
-        vector<int> a;
-	a.push_back(0);
-	a.push_back(-1);
-        for(int j=0; j<n; j++)
-          a.push_back( static_cast<int>(posn(i,j)) );
-        constraints.push_back(a);
+// Tries to separate F with integer weights w, starting from the given guess.
+// The sums w.x are kept bit-sliced: S[b] holds bit b of w.x for every point,
+// so each step works on all tn points at once. If the lightest point of F is
+// no heavier than the heaviest point outside it, w is nudged towards the
+// former and away from the latter (a perceptron step), up to rounds times.
+const int sumbits = n+3;                      // n*tn/2 < 2^(n+3)
+bool weightsep(const bitset<tn>& F, int w[], int rounds){
+  const bitset<tn>* mask = posmask();
+  for(int r=0;r<=rounds;r++){
+    for(unsigned j=0;j<n;j++)                 //Keep sums within sumbits
+      if(w[j]<0 || w[j]>(int)tn/2)
+        return false;
+
+    bitset<tn> S[sumbits];
+    for(unsigned j=0;j<n;j++){                //S += w[j]*mask[j]
+      bitset<tn> carry;
+      for(int b=0;b<sumbits;b++){
+        if(carry.none() && (w[j]>>b)==0)
+          break;
+        bitset<tn> add = ((w[j]>>b)&1) ? mask[j] : bitset<tn>();
+        bitset<tn> half = S[b]^add;
+        bitset<tn> c = (S[b]&add)|(carry&half);
+        S[b] = half^carry;
+        carry = c;
       }
     }
-    else{
-      if(islowbound(i,F)){
-        vector<int> a;
-	a.push_back(-1);
-	a.push_back(1);
-        for(int j=0; j<n; j++)
-          a.push_back( -1*static_cast<int>(posn(i,j)) );
-        constraints.push_back(a);
+
+    int tmin=0, tmax=0;                       //Min of w.x over F, max off F
+    bitset<tn> low = F, high = ~F;
+    for(int b=sumbits-1;b>=0;b--){
+      bitset<tn> z = low&~S[b];
+      if(z.any())
+        low = z;
+      else
+        tmin |= 1<<b;
+      z = high&S[b];
+      if(z.any()){
+        high = z;
+        tmax |= 1<<b;
       }
     }
+    if(tmax<tmin)
+      return true;
+    if(high.none())
+      return false;
+
+    unsigned il = low._Find_first(), ih = high._Find_first();
+    for(unsigned j=0;j<n;j++)
+      w[j] += static_cast<int>(posn(il,j)) - static_cast<int>(posn(ih,j));
   }
-  
-  int num_cols = n+2;  
-  int num_rows = constraints.size()+ n-1; 	
-  
-  double **mat = new double*[num_rows+num_cols];
-  
+  return false;
+}
+
+// Separability tests settled by chowsep, and by ismonotonic, rather than
+// the LP, per thread
+thread_local lint sepcalls = 0, sephits = 0, seprejects = 0;
+int SEPROUNDS = 8;                            //Perceptron steps to try
+
+// Tries weights derived from the Chow parameters of F, the correlations
+// 2a[j]-|F|, refined by weightsep. The weights tried last are left in w.
+bool chowsep(const bitset<tn>& F, int w[]){
+  int a[n]; chowa(F,a);
+  int size = F.count();
+  for(unsigned j=0;j<n;j++)
+    w[j] = 2*a[j]-size;
+  return weightsep(F,w,SEPROUNDS);
+}
+
+bool chowsep(const bitset<tn>& F){
+  int w[n];
+  return chowsep(F,w);
+}
+
+// The boundary points of F, as ishighbound and islowbound find them one at
+// a time: high = points of F covering nothing in F, low = points outside F
+// covered by nothing outside F.
+void boundpoints(const bitset<tn>& F, bitset<tn>& high, bitset<tn>& low){
+  const CoverMasks& cm = covermasks();
+  bitset<tn> nF = ~F, above, below;
+  for(unsigned c=0;c<n;c++){
+    above |= (F&cm.cover[c]) << cm.shift[c];  //Covers a point of F
+    below |= (nF >> cm.shift[c])&cm.cover[c]; //Covered by a point outside F
+  }
+  high = F&~above;
+  low = nF&~below;
+}
+
+// Writes the LP for the separability of F into mat (rows of lpcols entries):
+// the objective, a row per boundary point of F, rows ordering the weights
+// and the identity. Returns the number of rows before the identity.
+template<typename T>
+int sepsystem(bitset<tn>& F, T* mat){
+  const int q = lpcols;
+  mat[0]=0;
+  for(int j=1;j<q;j++)
+    mat[j]=1;
+
+  bitset<tn> high, low;
+  boundpoints(F,high,low);
+  bitset<tn> bound = high|low;
+
   int i=1;
-  mat[0] = new double[num_cols];
-  mat[0][0]=0;
-  for(int j=1;j<num_cols;j++)
-    mat[0][j]=1.0;
-    
-  for(;i<=constraints.size();i++){
-    mat[i] = new double[num_cols];
-    for(int j=0;j<num_cols;j++){
-      mat[i][j]= static_cast<double>(constraints[i-1][j]);
+  for(unsigned x=bound._Find_first();x<tn;x=bound._Find_next(x),i++){
+    T* a = mat + i*q;
+    if(high.test(x)){
+      a[0]=0;
+      a[1]=-1;
+      for(unsigned j=0; j<n; j++)
+        a[j+2]=static_cast<T>(posn(x,j));
+    }
+    else{
+      a[0]=-1;
+      a[1]=1;
+      for(unsigned j=0; j<n; j++)
+        a[j+2]=-static_cast<T>(posn(x,j));
     }
   }
+
+  int num_rows = i-1 + n-1;
   for(int p=2;i<=num_rows;i++,p++){
-    mat[i] = new double[num_cols];
-    for(int j=0;j<num_cols;j++){
-      mat[i][j]=(j==p?-1:(j==p+1?1:0));
+    for(int j=0;j<q;j++){
+      mat[i*q+j]=(j==p?-1:(j==p+1?1:0));
     }  
   }
-  for(int p=1;i<num_rows+num_cols;i++,p++){
-    mat[i] = new double[num_cols];
-    for(int j=0;j<num_cols;j++)
-      mat[i][j]=(j==p?1:0);
+  for(int p=1;i<num_rows+q;i++,p++){
+    for(int j=0;j<q;j++)
+      mat[i*q+j]=(j==p?1:0);
   }  
-  double soln[num_cols];
-  bool sep = dual_simplex(mat,num_rows,num_cols,soln);
-
-  for(i=0;i<num_rows+num_cols;i++)
-    delete mat[i];
-  delete mat; 
-  
-  return sep;
+  return num_rows;
 }
+
+// LP tests that needed (and, in hybrid mode, were re-run in) exact arithmetic,
+// and those where exact arithmetic overflowed and the double result was kept
+thread_local lint exactcalls = 0, exactoverflows = 0;
+
+// The LP test of issep, in the arithmetic chosen by sepmode
 bool issep(bitset<tn>& F, double soln[]){
-  vector< vector<int> > constraints;
-  for(int i=0;i<tn;i++){
-    if(F.test(i)){
-      if(ishighbound(i,F)){
-        vector<int> a;
-	a.push_back(0);
-	a.push_back(-1);
-        for(int j=0; j<n; j++)
-          a.push_back( static_cast<int>(posn(i,j)) );
-        constraints.push_back(a);
-      }
-    }
-    else{
-      if(islowbound(i,F)){
-        vector<int> a;
-	a.push_back(-1);
-	a.push_back(1);
-        for(int j=0; j<n; j++)
-          a.push_back( -1*static_cast<int>(posn(i,j)) );
-        constraints.push_back(a);
-      }
-    }
+  LPArena& lp = lparena();
+  if(sepmode!=SEPEXACT){
+    lpdoubt = false;
+    bool sep = dual_simplex(lp.mat,sepsystem(F,lp.mat),lpcols,soln);
+    if(sepmode==SEPFLOAT || !lpdoubt)
+      return sep;
   }
-  
-  int num_cols = n+2;  
-  int num_rows = constraints.size()+ n-1; 	
-  
-  double **mat = new double*[num_rows+num_cols];
-  
-  int i=1;
-  mat[0] = new double[num_cols];
-  mat[0][0]=0;
-  for(int j=1;j<num_cols;j++)
-    mat[0][j]=1.0;
-    
-  for(;i<=constraints.size();i++){
-    mat[i] = new double[num_cols];
-    for(int j=0;j<num_cols;j++){
-      mat[i][j]= static_cast<double>(constraints[i-1][j]);
-    }
+  exactcalls++;
+  int sep = exact_simplex(lp.imat,sepsystem(F,lp.imat),lpcols,soln);
+  if(sep>=0)
+    return sep;
+  exactoverflows++;
+  return dual_simplex(lp.mat,sepsystem(F,lp.mat),lpcols,soln);
+}
+
+// Tests whether a boolean function F is a linear threshold function
+bool issep(bitset<tn>& F){
+  sepcalls++;
+  if(!ismonotonic(F)){                        //Most non-LTFs fail 2-summability
+    seprejects++;
+    return false;
   }
-  for(int p=2;i<=num_rows;i++,p++){
-    mat[i] = new double[num_cols];
-    for(int j=0;j<num_cols;j++){
-      mat[i][j]=(j==p?-1:(j==p+1?1:0));
-    }  
+  if(chowsep(F)){                             //Cheap guess next, LP if it fails
+    sephits++;
+    return true;
   }
-  for(int p=1;i<num_rows+num_cols;i++,p++){
-    mat[i] = new double[num_cols];
-    for(int j=0;j<num_cols;j++)
-      mat[i][j]=(j==p?1:0);
-  }  
-  bool sep = dual_simplex(mat,num_rows,num_cols,soln);
 
-  for(i=0;i<num_rows+num_cols;i++)
-    delete mat[i];
-  delete mat; 
-  
-  return sep;
+  double soln[lpcols];
+  return issep(F,soln);
+}
+
+// True if w separates F, with threshold t: F(x) = 1 exactly when w.x >= t
+bool separates(const bitset<tn>& F, const int w[], int& t){
+  int tmin = INT_MAX, tmax = INT_MIN;
+  for(unsigned x=0;x<tn;x++){
+    int s = 0;
+    for(unsigned j=0;j<n;j++)
+      if(posn(x,j))
+        s += w[j];
+    if(F.test(x))
+      tmin = std::min(tmin,s);
+    else
+      tmax = std::max(tmax,s);
+  }
+  t = tmin;
+  return tmax<tmin;
+}
+
+// Integer weights w and threshold t realizing the LTF F: the weight guess
+// of chowsep if it works, else the LP solution of issep, rounded, or scaled
+// by n+1 and then rounded (its margin of 1 then outweighs the n roundings).
+// False if F is not an LTF.
+bool sepweights(bitset<tn>& F, int w[], int& t){
+  if(chowsep(F,w))
+    return separates(F,w,t);
+
+  double soln[lpcols];
+  if(!issep(F,soln))
+    return false;
+  for(unsigned s=1;s<=n+1;s+=n){
+    for(unsigned j=0;j<n;j++)
+      w[j] = static_cast<int>(std::lround(s*soln[j+2]));
+    if(separates(F,w,t))
+      return true;
+  }
+  return false;
 }
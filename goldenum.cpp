@@ -0,0 +1,235 @@
+// goldenum.cpp
+// by Nicolle Gruzling 
+// Adapted by Connor Halleck-Dube as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// The generator of GoldilocksEnumParallel.cpp for a single n. It expects n
+// to be defined before it is included; GoldilocksEnumParallel.cpp includes
+// it once per supported n, each time in a namespace of its own.
+
+const unsigned tn = 1<<n;
+
+vector<int> Great[tn],Less[tn];
+
+#include "functions.cpp"
+#include "candfile.cpp"
+#include "enumerate.cpp"
+
+// Store output 
+std::string outdir = "/home/fas/payne_sam/cjh69/project/";
+std::string outname;
+
+// With --shard k/N, this process generates only the k-th of N disjoint
+// parts of the tree: every N-th of the subtrees splittree makes, from the
+// k-th on. Shard 0 also generates the functions at the nodes split.
+int shard = 0, shards = 1;
+const int SHARDSPLIT = 256;			// Subtrees per shard
+
+// Number of threads allowed (must agree with cluster allowance);
+// --threads k sets it
+int MAXTHREADS = 16;
+
+ofstream outfile;
+WriteBuffer* wbs;					// One write buffer per worker
+
+// With --check, each worker counts the functions it generated whose Chow
+// parameters are out of order (see enumerate.cpp: there should be none)
+bool checkcanon = false;
+lint* noncanon;
+
+void emit(int id, bitset<tn>& F) {
+	if (checkcanon) {
+		int a[n]; chowa(F, a);
+		for (unsigned j = 0; j+1 < n; j++)
+			if (a[j] > a[j+1]) {
+				noncanon[id]++;
+				break;
+			}
+	}
+	write(outfile, wbs[id], F);
+}
+
+void finish(int id) {
+	flush(outfile, wbs[id]);
+}
+
+// Checkpoints of the DFS, saved every CHECKPOINTEVERY seconds.
+// Format (64-bit little-endian words): magic "GOLDEKPT", n, shard k and the
+// number of shards N, the number of functions generated (and written to
+// the candidate file), their checksum, the number of subtrees left, each
+// subtree as its packed F and free, and last a hash of all the words
+// before it.
+int CHECKPOINTEVERY = 600;
+std::string ckptname;
+
+// Called with the workers paused and their buffers flushed. The candidate
+// file is synced first, so the checkpoint never counts records that did not
+// reach the disk.
+void save(const vector<Frame>& left, lint count) {
+	outfile.flush();
+	int fd = ::open(outname.c_str(), O_WRONLY);
+	bool synced = fd >= 0 && ::fsync(fd) == 0;
+	if (fd >= 0)
+		::close(fd);
+	if (!synced) {
+		cerr << "Checkpoint failed" << endl;
+		return;
+	}
+	uint64_t checksum = 0;
+	for (int i = 0; i < MAXTHREADS; i++)
+		checksum += wbs[i].checksum;
+
+	vector<uint64_t> w(7 + 2*recwords*left.size());
+	memcpy(&w[0], "GOLDEKPT", 8);
+	w[1] = n;
+	w[2] = shard;
+	w[3] = shards;
+	w[4] = count;
+	w[5] = checksum;
+	w[6] = left.size();
+	for (size_t i = 0; i < left.size(); i++) {
+		pack(left[i].F, &w[7 + 2*recwords*i]);
+		pack(left[i].free, &w[7 + 2*recwords*i + recwords]);
+	}
+	w.push_back(hashwords(&w[0], w.size()));
+
+	if (!savewords(ckptname, &w[0], w.size()))
+		cerr << "Checkpoint failed" << endl;
+}
+
+// Reads the last checkpoint; false if there is none or it is damaged
+bool load(vector<Frame>& left, lint& count, uint64_t& checksum) {
+	ifstream ckpt(ckptname, ios::binary | ios::ate);
+	if (!ckpt)
+		return false;
+	size_t words = ckpt.tellg()/8;
+	if (words < 8)
+		return false;
+	vector<uint64_t> w(words);
+	ckpt.seekg(0);
+	if (!ckpt.read((char*) &w[0], 8*words))
+		return false;
+	if (memcmp(&w[0], "GOLDEKPT", 8) != 0 || w[1] != n
+			|| w[2] != (uint64_t) shard || w[3] != (uint64_t) shards
+			|| words != 8 + 2*recwords*w[6] || w[words-1] != hashwords(&w[0], words-1))
+		return false;
+
+	count = w[4];
+	checksum = w[5];
+	left.resize(w[6]);
+	for (size_t i = 0; i < left.size(); i++) {
+		unpack(&w[7 + 2*recwords*i], left[i].F);
+		unpack(&w[7 + 2*recwords*i + recwords], left[i].free);
+	}
+	return true;
+}
+
+// Main for this n
+int run(int argc, char* argv[]) {
+	bool resume = false;
+	for (int a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "--n") == 0 && a+1 < argc)
+			a++;						// Already chosen by main
+		else if (strcmp(argv[a], "--check") == 0)
+			checkcanon = true;
+		else if (strcmp(argv[a], "--resume") == 0)
+			resume = true;
+		else if (strcmp(argv[a], "--checkpoint") == 0 && a+1 < argc)
+			CHECKPOINTEVERY = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--threads") == 0 && a+1 < argc)
+			MAXTHREADS = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--shard") == 0 && a+1 < argc) {
+			if (!parseshard(argv[++a], shard, shards)) {
+				cerr << "Shard must be k/N with 0 <= k < N" << endl;
+				return 1;
+			}
+		}
+		else {
+			cerr << "Unknown argument " << argv[a] << endl;
+			return 1;
+		}
+	}
+	if (CHECKPOINTEVERY < 1) {
+		cerr << "Checkpoint interval must be at least 1 s" << endl;
+		return 1;
+	}
+	if (MAXTHREADS < 1) {
+		cerr << "Number of threads must be at least 1" << endl;
+		return 1;
+	}
+	outname = outdir + "GoldCands" + std::to_string(n) + shardtag(shard, shards) + ".dat";
+	ckptname = outdir + "GoldEnumCkpt" + std::to_string(n) + shardtag(shard, shards) + ".dat";
+
+	lint tcount=0;				        	//Number of testcases.
+	BigInt septotal(tcount);
+
+	// Pick up the DFS where the last checkpoint left it
+	vector<Frame> left;
+	uint64_t checksum = 0;
+	if (resume) {
+		if (!load(left, tcount, checksum)) {
+			cerr << "No usable checkpoint " << ckptname << endl;
+			return 1;
+		}
+		// Workers write in a different order on every run, so the records
+		// kept must be the very ones the checkpoint counted
+		uint64_t kept;
+		if (!trimcands(outname.c_str(), tcount)
+				|| !sumcands(outname.c_str(), tcount, kept) || kept != checksum) {
+			cerr << outname << " does not match checkpoint " << ckptname << endl;
+			return 1;
+		}
+		if (!reopencands(outfile, outname.c_str())) {
+			cerr << "Cannot reopen " << outname << endl;
+			return 1;
+		}
+		cout << "Resuming with " << tcount << " generated, ";
+		cout << left.size() << " subtrees left" << endl;
+	}
+	else {
+		if (!opencands(outfile, outname.c_str())) {
+			cerr << "Cannot open " << outname << endl;
+			return 1;
+		}
+		unlink(ckptname.c_str());		// Left by an earlier run
+	}
+
+	lessgreatinit(Great,Less);
+	initless(lessa);
+
+	noncanon = new lint[MAXTHREADS]();
+	wbs = new WriteBuffer[MAXTHREADS];
+	wbs[0].count = tcount;				// Already in the file
+	wbs[0].checksum = checksum;
+
+	// Take this shard's part of the tree
+	if (!resume && shards > 1) {
+		vector<Frame> parts;
+		vector<bitset<tn>> inner;
+		splittree(SHARDSPLIT*shards, parts, inner);
+		for (size_t i = shard; i < parts.size(); i += shards)
+			left.push_back(parts[i]);
+		if (shard == 0)
+			for (size_t i = 0; i < inner.size(); i++)
+				emit(0, inner[i]);
+		tcount = wbs[0].count;
+	}
+
+	lint stolen;
+	tcount = enumerate(MAXTHREADS, emit, finish, stolen,
+		(resume || shards > 1) ? &left : NULL, tcount, CHECKPOINTEVERY, save);
+	closecands(outfile, wbs, MAXTHREADS, shard, shards > 1 ? shards : 0);
+	unlink(ckptname.c_str());			// Nothing left to resume
+	delete[] wbs;
+
+	cout<<"\nNumber Generated : "<<tcount<<endl;
+	cout<<"Subtrees Stolen : "<<stolen<<endl;
+	if (checkcanon) {
+		lint bad = 0;
+		for (int i = 0; i < MAXTHREADS; i++)
+			bad += noncanon[i];
+		cout<<"Not Canonical : "<<bad<<endl;
+	}
+	delete[] noncanon;
+	return 0;
+}
@@ -0,0 +1,49 @@
+// goldformat.h
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// What GoldilocksTestParallel.cpp and the tools reading its output
+// (GoldilocksMerge.cpp, GoldilocksResults.cpp) must agree on: the known
+// numbers of candidates, 128-bit totals in decimal, and the header of a
+// result file, whose format is described in resultfile.cpp.
+
+#ifndef GOLDFORMAT_H
+#define GOLDFORMAT_H
+
+#include <cstdint>
+#include <string>
+
+// Unsigned 128-bit integers, for the totals of orbit sizes
+typedef unsigned __int128 wide;
+
+// Number of candidates on n variables, where known, else -1
+constexpr long long KNOWNTOTALS[] = {3, 7, 21, 135, 2470, 319124, 1214554343};
+constexpr long long knowntotal(int n) {
+	return (n >= 3 && n <= 9) ? KNOWNTOTALS[n-3] : -1;
+}
+
+inline std::string widestr(wide x) {
+	std::string s;
+	do {
+		s.insert(s.begin(), char('0' + (int) (x % 10)));
+		x /= 10;
+	} while (x > 0);
+	return s;
+}
+
+const unsigned resversion = 1;
+const uint64_t RESINDEX = 1, RESWEIGHTS = 2;
+
+struct ResultHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t n;
+	uint64_t flags;
+	uint64_t count;
+	uint64_t recwords;
+	uint64_t filesum;
+	uint64_t unchecked;
+	uint64_t reserved;
+};
+
+#endif
@@ -0,0 +1,929 @@
+// goldtest.cpp
+// by Connor Halleck-Dube
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// The tester of GoldilocksTestParallel.cpp for a single n. It expects n and
+// TOTALT to be defined before it is included; GoldilocksTestParallel.cpp
+// includes it once per supported n, each time in a namespace of its own.
+
+// WARNING: For ease of parallelization and error-checking, 
+// this version of the program checks the number tested against the total
+// # of candidates on n variables TOTALT, where it is already known.
+// Otherwise (TOTALT < 0) it checks against the number in the candidate
+// file, or the number generated in fused mode.
+
+const unsigned tn = 1<<n;
+
+vector<int> Great[tn];
+vector<int> Less[tn];
+
+#include "functions.cpp"
+#include "candfile.cpp"
+#include "resultfile.cpp"
+#include "enumerate.cpp"
+
+// Maximum number of elements in the test queue at once
+const int QUEUEMAX = 5000;
+
+// Thread-safe queue for the functions (fused mode)
+// Producers block on candq while it holds QUEUEMAX functions
+BoundedQueue<bitset<tn>> candq(QUEUEMAX);
+
+// Number of threads allowed (must agree with cluster allowance)
+int MAXTHREADS = 16;
+
+// Number of tester threads (the rest produce candidates)
+int numtesters = MAXTHREADS-1;
+
+// Number of enumerator threads feeding candq in fused mode
+int ENUMTHREADS = 2;
+
+// Number of functions moved through candq at once
+int BATCH = 64;
+
+// How often the reporter samples progress (s)
+int REPORTEVERY = 10;
+
+// Name of the file holding the candidates (--read overrides it)
+std::string readname = "/home/fas/payne_sam/cjh69/project/GoldCands" + std::to_string(n) + ".dat";
+
+// Names of the files holding the results, the log and the checkpoint.
+// The tags of a sharded run are added to them once the file is mapped.
+std::string outdir = "/home/fas/payne_sam/cjh69/";
+std::string outname, logname, ckptname;
+
+// With --shard k/N, this process tests only the k-th of N equal ranges
+// [lo, hi) of the records in the candidate file. GoldilocksMerge adds up
+// the Result lines of the shards.
+int shard = 0, shards = 1;
+lint lo = 0, hi = 0;
+
+// Number of candidates to be tested: TOTALT, or once known, the number
+// in the candidate file or generated
+std::atomic<lint> expected(TOTALT);
+
+// File mode: the mapped candidate file, handed out in chunks of records
+CandMap cands;
+const lint CHUNKRECS = 4096;
+std::atomic<lint> nextchunk(0);
+
+// Totals of the four classes over a set of tested functions. Each is a
+// BigAccum, a machine word carried into a BigInt on the rare wrap, so they
+// are exact however far they grow.
+struct Totals {
+	BigAccum tested;
+	BigAccum GLcount;				// Number of Hassett chambers
+	BigAccum GLcountSn;				// Number of Hassett chambers quotiented by Sn
+	BigAccum PScount;
+	BigAccum PScountSn;
+};
+
+// t += x
+void accumulate(Totals& t, const Totals& x) {
+	t.tested.merge(x.tested);
+	t.GLcount.merge(x.GLcount);
+	t.GLcountSn.merge(x.GLcountSn);
+	t.PScount.merge(x.PScount);
+	t.PScountSn.merge(x.PScountSn);
+}
+
+// Adds one tested function and its counts GL, GL/Sn, PS, PS/Sn to t
+void tally(Totals& t, const lint c[4]) {
+	t.tested.add(1ULL);
+	t.GLcount.add((unsigned long long) c[0]);
+	t.GLcountSn.add((unsigned long long) c[1]);
+	t.PScount.add((unsigned long long) c[2]);
+	t.PScountSn.add((unsigned long long) c[3]);
+}
+
+// A total as 128 bits, for checkpoints and progress reports; it saturates
+// in the (never seen) case that it needs more
+wide approx(const BigAccum& a) {
+	wide x;
+	return a.get(x) ? x : ~(wide) 0;
+}
+
+// Where a tester's candidates come from
+struct Source {
+	lint next = 0, end = 0;			// File mode: records still to decode
+	uint64_t checksum = 0;			// Checksum of all records it decoded
+	lint chunk = -1;				// File mode: the chunk being tested,
+	Totals chunktotals;				//   its totals so far
+	uint64_t chunksum = 0;			//   and its checksum
+	vector<bitset<tn>> batch;		// Fused mode: last batch taken from candq
+	size_t bi = 0, bn = 0;
+};
+Source* sources;
+
+// File mode checkpoints. Chunks finish out of order, so each finished
+// chunk's totals wait in done until every chunk before it has finished;
+// committed then holds the totals of the first frontier chunks. The
+// reporter saves these every CHECKPOINTEVERY seconds, and --resume starts
+// again from the first unfinished chunk.
+int CHECKPOINTEVERY = 600;
+bool resume = false;
+
+struct Done {
+	Totals t;
+	uint64_t checksum;
+};
+std::mutex ckptMut;
+std::map<lint, Done> done;
+lint frontier = 0;
+Totals committed;
+uint64_t committedsum = 0;
+
+// Totals and checksum of the chunks finished by the run being resumed
+Totals resumed;
+uint64_t resumedsum = 0;
+
+// Records that tester src has finished its chunk
+void finishchunk(Source& src) {
+	if (src.chunk < 0)
+		return;
+	std::lock_guard<std::mutex> lock(ckptMut);
+	done[src.chunk] = Done{src.chunktotals, src.chunksum};
+	while (!done.empty() && done.begin()->first == frontier) {
+		accumulate(committed, done.begin()->second.t);
+		committedsum += done.begin()->second.checksum;
+		done.erase(done.begin());
+		frontier++;
+	}
+	src.chunk = -1;
+	src.chunktotals = Totals();
+	src.chunksum = 0;
+}
+
+// Checkpoint file format (all integers little-endian, 64-bit): magic
+// "GOLDCKPT", n, the candidate file's count and checksum, the range of
+// records [lo, hi) being tested, the number of chunks finished, the
+// checksum of their records, their totals (tested, GLcount, GLcountSn,
+// PScount, PScountSn, each as its low and high word), and last a hash of
+// all the words before it.
+const int ckptwords = 19;
+
+// Saves the committed totals, replacing the old checkpoint atomically and
+// durably
+bool savecheckpoint() {
+	uint64_t w[ckptwords];
+	{
+		std::lock_guard<std::mutex> lock(ckptMut);
+		Totals t = resumed;
+		accumulate(t, committed);
+		memcpy(w, "GOLDCKPT", 8);
+		w[1] = n;
+		w[2] = cands.header.count;
+		w[3] = cands.header.checksum;
+		w[4] = lo;
+		w[5] = hi;
+		w[6] = frontier;
+		w[7] = resumedsum + committedsum;
+		const BigAccum* totals[5] = {&t.tested, &t.GLcount, &t.GLcountSn,
+			&t.PScount, &t.PScountSn};
+		for (int i = 0; i < 5; i++) {
+			wide x;
+			if (!totals[i]->get(x))
+				return false;
+			w[8+2*i] = (uint64_t) x;
+			w[9+2*i] = (uint64_t) (x >> 64);
+		}
+	}
+	w[18] = hashwords(w, ckptwords-1);
+	return savewords(ckptname, w, ckptwords);
+}
+
+// Reads a checkpoint for this candidate file into resumed; returns the
+// number of chunks it covers, or -1 if there is no usable checkpoint
+lint loadcheckpoint() {
+	uint64_t w[ckptwords];
+	ifstream ckpt(ckptname, ios::binary);
+	if (!ckpt.read((char*) w, sizeof(w)))
+		return -1;
+	if (memcmp(w, "GOLDCKPT", 8) != 0 || w[1] != n
+			|| w[2] != cands.header.count || w[3] != cands.header.checksum
+			|| w[4] != (uint64_t) lo || w[5] != (uint64_t) hi
+			|| w[18] != hashwords(w, ckptwords-1))
+		return -1;
+	resumedsum = w[7];
+	BigAccum* totals[5] = {&resumed.tested, &resumed.GLcount, &resumed.GLcountSn,
+		&resumed.PScount, &resumed.PScountSn};
+	for (int i = 0; i < 5; i++)
+		totals[i]->add(((wide) w[9+2*i] << 64) | w[8+2*i]);
+	return w[6];
+}
+
+// One tester's running totals as 128 bits (see approx), two words each, for
+// the reporter. Only that tester writes them; seq is odd while it does, so
+// readers can retry rather than see a half-written total.
+struct Published {
+	std::atomic<unsigned> seq;
+	std::atomic<uint64_t> total[5][2];	// tested, GL, GL/Sn, PS, PS/Sn
+	char pad[64];					// Keep testers off each other's cache lines
+};
+Published* published;
+
+void publish(Published& p, const Totals& t) {
+	const BigAccum* totals[5] = {&t.tested, &t.GLcount, &t.GLcountSn,
+		&t.PScount, &t.PScountSn};
+	unsigned s = p.seq.load(std::memory_order_relaxed);
+	p.seq.store(s+1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (int i = 0; i < 5; i++) {
+		wide x = approx(*totals[i]);
+		p.total[i][0].store((uint64_t) x, std::memory_order_relaxed);
+		p.total[i][1].store((uint64_t) (x >> 64), std::memory_order_relaxed);
+	}
+	p.seq.store(s+2, std::memory_order_release);
+}
+
+// Adds the totals last published in p to t
+void addpublished(Totals& t, const Published& p) {
+	wide x[5];
+	unsigned s;
+	do {
+		s = p.seq.load(std::memory_order_acquire);
+		for (int i = 0; i < 5; i++)
+			x[i] = ((wide) p.total[i][1].load(std::memory_order_relaxed) << 64)
+				| p.total[i][0].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((s & 1) || p.seq.load(std::memory_order_relaxed) != s);
+	t.tested.add(x[0]);
+	t.GLcount.add(x[1]);
+	t.GLcountSn.add(x[2]);
+	t.PScount.add(x[3]);
+	t.PScountSn.add(x[4]);
+}
+
+// How often each tester's issep was settled by the 2-monotonicity test
+// (ismonotonic) or the weight guess (chowsep) before the LP
+struct SepStats {
+	lint calls = 0, hits = 0;
+	lint rejects = 0;				// Rejected by ismonotonic
+	lint exact = 0, overflows = 0;	// LP tests run exactly, and overflowed
+};
+SepStats* sepstats;
+
+// Sums the totals published so far (and those of the run resumed)
+Totals sample() {
+	Totals t = resumed;
+	for (int i = 0; i < numtesters; i++)
+		addpublished(t, published[i]);
+	return t;
+}
+
+// Each tester's own totals, exact, once it has finished
+Totals* finals;
+
+// Fused mode: candidates come from enumerator threads through candq
+bool fused = false;
+
+// Fused mode: optional copy of the generated candidates (for debugging)
+char* candname = NULL;
+ofstream candfile;
+WriteBuffer* candbufs;
+
+// With --results, the counts of each LTF tested go to a result file,
+// with --weights its integer weights too (see resultfile.cpp)
+char* resname = NULL;
+bool resweights = false;
+uint64_t resflags = 0;
+ResultWriter resw;
+ResultBuffer* resbufs;
+
+// The log and the results, each written by a thread of its own, so that
+// no tester ever waits on the filesystem
+AsyncWriter logw, outw;
+
+void log(std::string const& msg) {
+	logw.write(msg);
+}
+
+void output(std::string S) {
+	outw.write(S);
+}
+
+// Gets the next candidate for tester id; false once its input is used up
+bool nextcand(int id, moodycamel::ConsumerToken& ctok, bitset<tn>& F) {
+	Source& src = sources[id];
+	if (fused) {
+		if (src.bi == src.bn) {		// Wait for a new batch in queue
+			src.batch.resize(BATCH);
+			src.bn = candq.wait_dequeue_bulk(ctok, src.batch.begin(), BATCH);
+			src.bi = 0;
+		}
+		F = src.batch[src.bi++];
+
+		if ((F.test(0) == 1) && (F.test(1) == 0)) { // Not a positive LTF
+			// Termination signal. Anything taken with it is a kill token
+			// for another tester, so pass those on.
+			if (src.bi < src.bn)
+				candq.enqueue_bulk(src.batch.begin() + src.bi, src.bn - src.bi);
+			return false;
+		}
+		return true;
+	}
+
+	if (src.next == src.end) {		// Claim the next chunk of the file
+		finishchunk(src);
+		lint chunk = nextchunk++;
+		lint first = lo + CHUNKRECS*chunk;
+		if (first >= hi)
+			return false;
+		src.chunk = chunk;
+		src.next = first;
+		src.end = std::min<lint>(first + CHUNKRECS, hi);
+	}
+	const uint64_t* rec = cands.recs + src.next*recwords;
+	unpack(rec, F);
+	uint64_t h = candhash(rec);
+	src.checksum += h;
+	src.chunksum += h;
+	src.next++;
+	return true;
+}
+
+// Thread function: Tests boolean functions F for separability. 
+// If separable, puts (m, n, s, t) in retvals
+// where m is the number of goldilocks functions associated to F 
+// 		 n is the number of goldilocks LTFs up to symmetry associated to F
+// 		 s is the number of positive, small LTFs associated to F
+// 		 t is the number of PS LTFs up to symmetry associated to F
+// Adds them to its own totals, which are combined at the end
+void tester(int id){
+
+	moodycamel::ConsumerToken ctok(candq.q); // Consumes from candq
+	Published& pub = published[id];
+	Totals mine;
+	std::tuple<lint, lint, lint, lint> retvals;
+	bitset<tn> F;
+	// Iterate until the input runs out (or a kill-sentry is found)
+	while(nextcand(id, ctok, F)){
+		// Holds the number of classes of each of 4 types associated with F
+		retvals = std::make_tuple(0, 0, 0, 0);
+		
+		/* If an LTF, generate # of goldilocks functions in its orbit */
+		/* Place into retvals */
+		bool ltf = issep(F);
+		if (ltf) { 
+			// Get the dual
+			bitset<tn> Fd;
+			dual(F, Fd); 
+
+			// Store self-dualization as double-long array
+			int FSD[2 * tn];
+			for (unsigned i = 0; i < tn; i++) {
+				FSD[i] = F.test(i);
+				FSD[i + tn] = Fd.test(i);
+			}
+
+			// And chow parameters
+			// Since self-dual, the extra zeroth chow parameter is 2^(n+1)/2 = 2^n
+			// Each other chow parameter of the self-dualization is double.
+			int chow[n + 1];
+			chowdualup(F, chow);		// The self-dualization has parameters double these
+			
+			// For each distinct anti-self-dualization
+			bool newantisd = true;	// If this antiselfdual is distinct from those tested
+			for (unsigned i = 0; i <= n; i++) {
+				if (!newantisd) {
+					if (chow[i] != chow[i - 1]) {
+						newantisd = true;
+					}
+				}
+
+				if (newantisd) {
+					// If self-dual pair
+					if (chow[i] == tn / 2) {
+						// Test xi = 0 for smallness
+						bool isSmall = true;
+						for (unsigned j = 1; j <= n; j++) {	// testing the singleton values
+							if ((FSD[two(j)]) && (j != i)) {
+								isSmall = false;
+								break;
+							}
+						}
+						if (isSmall) {
+							// Sn multiplicity computation
+							// reps = size of Sn orbit of generator
+							static lint max = facts()[n];
+							lint reps = max;
+							int rchow[n];			// Get reduced chow parameters
+							int p = 0;
+							for (unsigned j = 0; j <= n; j++) {
+								if (j != i) {
+									rchow[p] = chow[j];
+									p++;
+								}
+							}
+
+							int pcount = 1;
+							for (unsigned j = 1; j < n; j++) {
+								if (rchow[j] == rchow[j - 1]) {
+									pcount++;
+								}
+								else {
+									reps /= facts()[pcount];
+									pcount = 1;
+								}
+							}
+							reps /= facts()[pcount];
+
+							// Record number of classes from this generator
+							get<0>(retvals) += reps;
+							get<1>(retvals) += 1;
+							get<2>(retvals) += reps;
+							get<3>(retvals) += 1;
+						}
+					}
+					else { // Not self dual (distinct)
+						int numberPS = 2;			// Innocent until proven guilty
+
+						// Test xi = 0 for smallness
+						for (unsigned j = 1; j <= n; j++) {	// testing the singleton values
+							if ((FSD[two(j)]) && (j != i)) {
+								numberPS--;
+								break;
+							}
+						}
+
+						// Test xi = 1 smallness
+						int ti = two(i);
+						for (unsigned j = 1; j <= n; j++) {	// testing the singleton values
+							if ((FSD[two(j) + ti]) && (j != i)) {
+								numberPS--;
+								break;
+							}
+						}
+
+						// Now compute corresponding counts
+						if (numberPS > 0) {
+							
+							// Sn multiplicity computation
+							// reps = size of Sn orbit of the generator
+							static lint max = facts()[n];
+							lint reps = max;
+							int rchow[n];			// Get reduced chow parameters
+							int p = 0;
+							for (unsigned j = 0; j <= n; j++) {
+								if (j != i) {
+									rchow[p] = chow[j];
+									p++;
+								}
+							}
+
+							int pcount = 1;
+							for (unsigned j = 1; j < n; j++) {
+								if (rchow[j] == rchow[j - 1]) {
+									pcount++;
+								}
+								else {
+									reps /= facts()[pcount];
+									pcount = 1;
+								}
+							}
+							reps /= facts()[pcount];
+
+							// Record number of classes from this generator
+							if (numberPS == 2) {
+								get<0>(retvals) += reps;
+								get<1>(retvals) += 1;
+								get<2>(retvals) += reps;
+								get<2>(retvals) += reps;
+								get<3>(retvals) += 2;
+							}
+							else { // = 1
+								get<2>(retvals) += reps;
+								get<3>(retvals) += 1;
+							}
+						}
+					}
+					newantisd = false;
+				}
+			} // End for loop
+		} // End F sep/ F testing and enumerating
+
+		lint counts[4] = {std::get<0>(retvals), std::get<1>(retvals),
+			std::get<2>(retvals), std::get<3>(retvals)};
+		if (ltf && resname != NULL) {
+			int w[n+1] = {};
+			bool weighed = resweights && sepweights(F, w, w[n]);
+			if (resweights && !weighed) {
+				std::ostringstream stream;
+				stream << "Tester thread " << id << ": no weights found realising "
+					<< F.to_string() << "\n";
+				log(stream.str());
+			}
+			writeresult(resw, resbufs[id], resflags, sources[id].next-1, F, counts,
+				weighed ? w : NULL);
+		}
+
+		// Add number of classes to the running totals
+		tally(mine, counts);
+		publish(pub, mine);
+		if (!fused)
+			tally(sources[id].chunktotals, counts);
+
+	} // End while loop
+	if (resname != NULL)
+		flushresults(resw, resbufs[id]);
+	sepstats[id].calls = sepcalls;
+	sepstats[id].hits = sephits;
+	sepstats[id].rejects = seprejects;
+	sepstats[id].exact = exactcalls;
+	sepstats[id].overflows = exactoverflows;
+	finals[id] = mine;
+
+	std::ostringstream stream;
+	stream << "Tester thread " << id << " terminating after testing " << mine.tested.value() << " functions.\n";
+	log(stream.str());
+}
+
+// Writes the totals t in the form used for progress and final results
+void summary(std::ostream& stream, const Totals& t) {
+	stream << "n = " << n << "\n";
+	stream << "Number Tested : " << t.tested.value() << "\n";
+	stream << "Number Goldilocks(/Sn): " << t.GLcountSn.value() << "\n";
+	stream << "Number Goldilocks: " << t.GLcount.value() << "\n";
+	stream << "Number SemiGold(/Sn): " << t.PScountSn.value() << "\n";
+	stream << "Number SemiGold: " << t.PScount.value() << "\n";
+}
+
+// Lets main stop the reporter without waiting out its sleep
+std::mutex repMut;
+std::condition_variable repCV;
+bool testingdone = false;
+
+// Thread function: samples the testers' totals and records progress, and
+// in file mode saves checkpoints. It wakes often enough for both.
+void reporter(){
+	lint percent = 1;
+	auto lastckpt = std::chrono::steady_clock::now();
+	auto lastreport = lastckpt;
+	int every = fused ? REPORTEVERY : std::min(REPORTEVERY, CHECKPOINTEVERY);
+	std::unique_lock<std::mutex> lock(repMut);
+	while (!repCV.wait_for(lock, std::chrono::seconds(every),
+			[]{ return testingdone; })) {
+		auto now = std::chrono::steady_clock::now();
+		if (!fused && now - lastckpt >= std::chrono::seconds(CHECKPOINTEVERY)) {
+			if (!savecheckpoint())
+				log("Reporter: checkpoint failed.\n");
+			lastckpt = now;
+		}
+		if (now - lastreport < std::chrono::seconds(REPORTEVERY))
+			continue;
+		lastreport = now;
+
+		Totals t = sample();
+		lint total = expected.load();
+		wide tested = approx(t.tested);
+		if (total > 0 && tested*100/total >= (wide) percent) {
+			percent = tested*100/total;
+			std::stringstream stream;
+			stream << "Reporter: " << percent << "% complete.\n";
+			stream << "Current progress:\n";
+			summary(stream, t);
+			output(stream.str());
+
+			percent++;
+		}
+		else if (total <= 0) {		// Total not known yet: report every sample
+			std::stringstream stream;
+			stream << "Reporter: " << t.tested.value() << " tested.\n";
+			stream << "Current progress:\n";
+			summary(stream, t);
+			output(stream.str());
+		}
+	}
+}
+
+
+// Each enumerator thread's batch on its way to candq, and its token for
+// candq. The token is made on the thread's first batch: as a thread_local
+// object it would be built for every n by any thread touching one of them.
+thread_local vector<bitset<tn>> prodbatch;
+thread_local std::unique_ptr<moodycamel::ProducerToken> prodtok;
+
+moodycamel::ProducerToken& producertoken() {
+	if (!prodtok)
+		prodtok.reset(new moodycamel::ProducerToken(candq.q));
+	return *prodtok;
+}
+
+// Enumerator hook (fused mode): passes F straight to the testers
+void produce(int id, bitset<tn>& F) {
+	if (candname != NULL)
+		write(candfile, candbufs[id], F);
+
+	prodbatch.push_back(F);
+	if (prodbatch.size() == (size_t) BATCH) {
+		// Blocks while the queue is full
+		candq.enqueue_bulk(producertoken(), prodbatch.begin(), prodbatch.size());
+		prodbatch.clear();
+	}
+}
+
+void producedone(int id) {
+	if (!prodbatch.empty())
+		candq.enqueue_bulk(producertoken(), prodbatch.begin(), prodbatch.size());
+	prodbatch.clear();
+	if (candname != NULL)
+		flush(candfile, candbufs[id]);
+}
+
+// Main for this n: original thread spawns others, and then reads functions
+// into pool queue
+int run(int argc, char* argv[]) {
+	for (int a = 1; a < argc; a++) {
+		if (strcmp(argv[a], "--n") == 0 && a+1 < argc)
+			a++;					// Already chosen by main
+		else if (strcmp(argv[a], "--fused") == 0)
+			fused = true;
+		else if (strcmp(argv[a], "--producers") == 0 && a+1 < argc)
+			ENUMTHREADS = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--cands") == 0 && a+1 < argc)
+			candname = argv[++a];
+		else if (strcmp(argv[a], "--batch") == 0 && a+1 < argc)
+			BATCH = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--resume") == 0)
+			resume = true;
+		else if (strcmp(argv[a], "--checkpoint") == 0 && a+1 < argc)
+			CHECKPOINTEVERY = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--exact") == 0)
+			sepmode = SEPEXACT;
+		else if (strcmp(argv[a], "--hybrid") == 0)
+			sepmode = SEPHYBRID;
+		else if (strcmp(argv[a], "--results") == 0 && a+1 < argc)
+			resname = argv[++a];
+		else if (strcmp(argv[a], "--weights") == 0)
+			resweights = true;
+		else if (strcmp(argv[a], "--read") == 0 && a+1 < argc)
+			readname = argv[++a];
+		else if (strcmp(argv[a], "--shard") == 0 && a+1 < argc) {
+			if (!parseshard(argv[++a], shard, shards)) {
+				cerr << "Shard must be k/N with 0 <= k < N" << endl;
+				return(1);
+			}
+		}
+		else {
+			cerr << "Unknown argument " << argv[a] << endl;
+			return(1);
+		}
+	}
+	if (ENUMTHREADS < 1 || ENUMTHREADS >= MAXTHREADS) {	// Leave room for a tester
+		cerr << "Producers must be between 1 and " << MAXTHREADS-1 << endl;
+		return(1);
+	}
+	if (fused)
+		numtesters = MAXTHREADS-ENUMTHREADS;
+	if (fused && resume) {
+		cerr << "Only file mode runs can be resumed" << endl;
+		return(1);
+	}
+	if (fused && shards > 1) {
+		cerr << "Only file mode runs can be sharded" << endl;
+		return(1);
+	}
+	if (resume && resname != NULL) {
+		cerr << "A resumed run cannot write a result file" << endl;
+		return(1);
+	}
+	if (CHECKPOINTEVERY < 1) {
+		cerr << "Checkpoint interval must be at least 1 s" << endl;
+		return(1);
+	}
+	if (BATCH < 1 || BATCH*ENUMTHREADS > QUEUEMAX) {	// Batches must fit in candq
+		cerr << "Batch size must be between 1 and " << QUEUEMAX/ENUMTHREADS << endl;
+		return(1);
+	}
+
+	// Map the candidate file before starting; the names of the output
+	// files carry the enumerator shard it came from and the tester shard
+	std::string tag = shardtag(shard, shards);
+	if (!fused) {
+		if (!mapcands(readname.c_str(), cands)) {
+			cerr << "Cannot read " << readname << " as a finished candidate file" << endl;
+			return(1);
+		}
+		tag = shardtag(cands.header.shard, cands.header.shards) + tag;
+	}
+	outname = outdir + "GoldCounts" + std::to_string(n) + tag + ".txt";
+	logname = outdir + "GoldLog" + std::to_string(n) + tag + ".txt";
+	ckptname = outdir + "GoldCkpt" + std::to_string(n) + tag + ".dat";
+	if (!logw.open(logname) || !outw.open(outname)) {
+		cerr << "Cannot open " << logname << " or " << outname << endl;
+		return(1);
+	}
+
+	// Real main begins here
+	lessgreatinit(Great, Less);
+
+	std::stringstream stream;
+	stream << "Beginning execution at " << "\n";
+	log(stream.str());
+
+	// Check the candidate file's header
+	if (!fused) {
+		if (TOTALT >= 0 && cands.header.shards == 0 && cands.header.count != TOTALT) {
+			std::stringstream stream1;
+			stream1 << "Candidate file holds " << cands.header.count << " functions, ";
+			stream1 << "expected " << TOTALT << " -- terminating.\n";
+			log(stream1.str());
+			return(1);
+		}
+		lo = shard*cands.header.count/shards;
+		hi = (shard+1)*cands.header.count/shards;
+		expected = hi - lo;
+
+		if (resume) {
+			lint chunks = loadcheckpoint();
+			if (chunks < 0) {
+				cerr << "No usable checkpoint " << ckptname << endl;
+				log("No usable checkpoint for this candidate file -- terminating.\n");
+				return(1);
+			}
+			nextchunk = chunks;
+			frontier = chunks;
+			std::stringstream stream1;
+			stream1 << "Resuming after " << chunks << " chunks (";
+			stream1 << resumed.tested.value() << " functions tested).\n";
+			log(stream1.str());
+		}
+	}
+
+	if (resname != NULL) {
+		resflags = (fused ? 0 : RESINDEX) | (resweights ? RESWEIGHTS : 0);
+		if (!openresults(resw, resname, resflags, numtesters)) {
+			log("Cannot open result file -- terminating.\n");
+			return(1);
+		}
+		resbufs = new ResultBuffer[numtesters];
+	}
+
+	if (fused && candname != NULL) {
+		if (!opencands(candfile, candname)) {
+			log("Cannot open candidate file -- terminating.\n");
+			return(1);
+		}
+		candbufs = new WriteBuffer[ENUMTHREADS];
+	}
+
+	// Initial thread produces for candq
+	moodycamel::ProducerToken ptok(candq.q);
+
+	// Creates an army of tester threads
+	sources = new Source[numtesters];
+	published = new Published[numtesters]();
+	finals = new Totals[numtesters];
+	sepstats = new SepStats[numtesters];
+	std::thread thdary[numtesters];
+	for (int i = 0; i < numtesters; i++) {
+		thdary[i] = std::thread(tester, i);
+
+		std::stringstream stream;
+		stream << "Main: spawned tester thread " << i << endl;
+		log(stream.str());
+	}
+
+	// Creates the thread which reports progress
+	std::thread rep = std::thread(reporter);
+	log("Main: spawned reporter thread.\n");
+
+	if (fused) {
+		// Generate the candidates here instead of reading them
+		initless(lessa);
+
+		lint stolen;
+		lint tcount = enumerate(ENUMTHREADS, produce, producedone, stolen);
+		if (TOTALT < 0)
+			expected = tcount;
+		if (candname != NULL) {
+			closecands(candfile, candbufs, ENUMTHREADS);
+			delete[] candbufs;
+		}
+
+		std::stringstream stream3;
+		stream3 << "Main: generated " << tcount << " candidates (";
+		stream3 << stolen << " subtrees stolen).\n";
+		log(stream3.str());
+
+		// Candidates from different producers are not ordered with respect to
+		// the kill tokens, so let the testers drain the queue first
+		candq.drain();
+
+		// Once all have been generated, push numtesters terminating tokens into candq
+		bitset<tn> kill;
+		kill.set(0);
+		for (int i = 0; i < numtesters; i++)
+			candq.enqueue(ptok, kill); // Put the kill tokens in the queue
+
+		std::stringstream stream4;
+		stream4 << "Main: " << std::to_string(numtesters);
+		stream4 <<" kill-tokens sent, commencing wait.\n";
+		log(stream4.str());
+	}
+
+	// Then wait on termination
+	for (int i = 0; i < numtesters; i++) {
+		thdary[i].join();
+
+		std::stringstream stream2;
+		stream2 << "Main: received tester " << std::to_string(i);
+		stream2 << " thread termination.\n";
+		log(stream2.str());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(repMut);
+		testingdone = true;
+	}
+	repCV.notify_one();
+	rep.join();
+
+	if (resname != NULL) {
+		lint unchecked = closeresults(resw, resbufs, numtesters, resflags,
+			fused ? 0 : cands.header.checksum);
+		delete[] resbufs;
+		if (unchecked > 0) {
+			std::ostringstream stream;
+			stream << "Result file: " << unchecked << " LTFs without verified "
+				<< "weights (written as zeros).\n";
+			cerr << stream.str();
+			log(stream.str());
+		}
+	}
+
+	// Combine the testers' totals
+	Totals total = resumed;
+	for (int i = 0; i < numtesters; i++)
+		accumulate(total, finals[i]);
+	BigInt tested = total.tested.value();
+
+	// Output results
+	std::stringstream stream5;
+	stream5 << "Final Results!\n";
+	summary(stream5, total);
+	cout << stream5.str();
+	output(stream5.str());
+
+	SepStats seps;
+	for (int i = 0; i < numtesters; i++) {
+		seps.calls += sepstats[i].calls;
+		seps.hits += sepstats[i].hits;
+		seps.rejects += sepstats[i].rejects;
+		seps.exact += sepstats[i].exact;
+		seps.overflows += sepstats[i].overflows;
+	}
+	std::ostringstream stream6;
+	stream6 << "Separability: " << seps.calls << " tests, " << seps.rejects
+		<< " rejected as not 2-monotonic";
+	if (seps.calls > 0)
+		stream6 << " (" << 100.0*seps.rejects/seps.calls << "%)";
+	stream6 << ", " << seps.hits << " settled by weight guess";
+	if (seps.calls > 0)
+		stream6 << " (" << 100.0*seps.hits/seps.calls << "%)";
+	stream6 << ", rest by LP.\n";
+	if (sepmode != SEPFLOAT)
+		stream6 << "Exact LP: " << seps.exact << " tests, " << seps.overflows
+			<< " overflowed (double result kept).\n";
+	cout << stream6.str();
+	log(stream6.str());
+
+	// Every record must have been decoded exactly as written. A shard
+	// can only check its part of the sum; GoldilocksMerge checks the rest.
+	uint64_t checksum = resumedsum;
+	if (!fused) {
+		if (!savecheckpoint())
+			log("Main: final checkpoint failed.\n");
+		for (int i = 0; i < numtesters; i++)
+			checksum += sources[i].checksum;
+		unmapcands(cands);
+		if (shards == 1 && checksum != cands.header.checksum) {
+			log("Candidate file corrupt (checksum mismatch) -- results invalid.\n");
+			return(1);
+		}
+	}
+	if (tested != BigInt((unsigned long long) expected.load())) {
+		log("Number tested differs from the number of candidates -- results invalid.\n");
+		return(1);
+	}
+
+	// One line for GoldilocksMerge: the candidate file (its enumerator
+	// shard, record count and checksum), the records tested and the totals
+	if (!fused) {
+		std::stringstream stream7;
+		stream7 << "Result n=" << n << " file=" << cands.header.shard << "/"
+			<< cands.header.shards << " filecount=" << cands.header.count
+			<< " filesum=" << cands.header.checksum << " records=" << lo << "-" << hi
+			<< " checksum=" << checksum << " tested=" << tested
+			<< " GLSn=" << total.GLcountSn.value() << " GL=" << total.GLcount.value()
+			<< " PSSn=" << total.PScountSn.value() << " PS=" << total.PScount.value() << "\n";
+		cout << stream7.str();
+		output(stream7.str());
+	}
+
+	log("Main: Terminating all execution.\n");
+	logw.close();
+	outw.close();
+	return 0;
+}
@@ -0,0 +1,208 @@
+// resultfile.cpp
+// Developed as part of SUMRY 2017
+// https://arxiv.org/abs/1709.03663
+
+// Writing of per-LTF result files, the counts GoldilocksTestParallel.cpp
+// finds for each linear threshold function it tests (--results), read back
+// by GoldilocksResults.cpp. Like candfile.cpp, this expects n and tn to be
+// defined, and candfile.cpp and goldformat.h included, before it is included.
+
+// Result file format, version 1 (all integers little-endian):
+//   bytes  0-7   magic "GOLDRSLT"
+//   bytes  8-11  format version (1)
+//   bytes 12-15  n
+//   bytes 16-23  flags: RESINDEX if records are keyed by candidate index,
+//                RESWEIGHTS if they hold weights
+//   bytes 24-31  number of records
+//   bytes 32-39  64-bit words per record
+//   bytes 40-47  checksum of the candidate file tested (zero in fused mode)
+//   bytes 48-55  with RESWEIGHTS, the number of records whose weights could
+//                not be verified to realise their function; those records
+//                hold zero weights and threshold
+//   bytes 56-63  reserved (zero)
+// followed by a record per LTF, in no particular order:
+//   the key: with RESINDEX, the function's index in the candidate file (one
+//            word); otherwise the function packed as in candfile.cpp
+//   the counts GL, GL/Sn, PS, PS/Sn of the tester (one word each)
+//   with RESWEIGHTS, integer weights w[0..n-1] and a threshold t, 32 bits
+//            each, padded to a whole word: F(x) = 1 exactly when w.x >= t
+
+// The header, resversion and the flags are in goldformat.h, shared with
+// the readers.
+
+// Words in a record with these flags
+unsigned reswords(uint64_t flags) {
+	unsigned key = (flags & RESINDEX) ? 1 : recwords;
+	unsigned weights = (flags & RESWEIGHTS) ? (n+2)/2 : 0;
+	return key + 4 + weights;
+}
+
+const int resbufwords = 262144;			// Result block size (in words)
+
+// A block of records on its way to the result file
+struct ResultBlock {
+	uint64_t buffer[resbufwords];
+	int used = 0;						// Words currently in block
+};
+
+// The result file, written by a thread of its own in the manner of
+// asyncwriter.h. Testers fill blocks and hand the full ones over, taking an
+// empty one back at once; the writer thread appends the full blocks and
+// returns them. A tester waits only if every block is in flight, that is
+// if the disk cannot keep up.
+class ResultWriter {
+public:
+	ResultWriter() : stopping(false), running(false) {}
+	~ResultWriter() { stop(); }
+
+	// Opens name and starts the writer thread with nblocks blocks to go round
+	bool open(const char* name, int nblocks) {
+		file.open(name, ios::binary);
+		if (!file)
+			return false;
+		for (int i = 0; i < nblocks; i++)
+			blocks.push_back(new ResultBlock());
+		empty.enqueue_bulk(blocks.begin(), blocks.size());
+		stopping = false;
+		running = true;
+		thread = std::thread(&ResultWriter::run, this);
+		return true;
+	}
+
+	// An empty block
+	ResultBlock* take() {
+		ResultBlock* b;
+		empty.wait_dequeue(b);
+		return b;
+	}
+
+	// Queues a full block to be written
+	void hand(ResultBlock* b) {
+		full.enqueue(b);
+	}
+
+	// Writes every block handed over, then stops the writer thread
+	void stop() {
+		if (!running)
+			return;
+		stopping.store(true, std::memory_order_release);
+		full.enqueue(NULL);				// Wake the writer
+		thread.join();
+		running = false;
+		for (ResultBlock* b : blocks)
+			delete b;
+		blocks.clear();
+	}
+
+	// The file itself, for the header once stop() has returned
+	ofstream file;
+
+private:
+	void run() {
+		ResultBlock* b;
+		while (true) {
+			// Seen before the dequeue, so every block handed over before
+			// stop is written; the queue does not order blocks from
+			// different testers behind the wake-up
+			bool stop = stopping.load(std::memory_order_acquire);
+			bool got = stop ? full.try_dequeue(b) : (full.wait_dequeue(b), true);
+			if (!got)
+				break;
+			if (b == NULL)
+				continue;
+			file.write((char*) b->buffer, 8*b->used);
+			b->used = 0;
+			empty.enqueue(b);
+		}
+	}
+
+	moodycamel::BlockingConcurrentQueue<ResultBlock*> full, empty;
+	vector<ResultBlock*> blocks;
+	std::thread thread;
+	std::atomic<bool> stopping;
+	bool running;
+};
+
+// A tester's share of the result file: the block it is filling, and how
+// many records it has written
+struct ResultBuffer {
+	ResultBlock* block = NULL;
+	lint count = 0;						// Number of records written through it
+	lint unchecked = 0;					//   of which without verified weights
+};
+
+// Hands over the tester's block, if it holds anything
+void flushresults(ResultWriter& rw, ResultBuffer& rb) {
+	if (rb.block != NULL && rb.block->used > 0) {
+		rw.hand(rb.block);
+		rb.block = NULL;
+	}
+}
+
+// Buffered write of one record. key is the candidate index (RESINDEX) or
+// F; w holds the weights and threshold (RESWEIGHTS), or is NULL if none
+// realising F were found, in which case zeros are written and counted.
+void writeresult(ResultWriter& rw, ResultBuffer& rb, uint64_t flags,
+		uint64_t index, const bitset<tn>& F, const lint counts[4], const int w[]) {
+	if (rb.block != NULL && rb.block->used + reswords(flags) > (unsigned) resbufwords)
+		flushresults(rw, rb);
+	if (rb.block == NULL)
+		rb.block = rw.take();
+	uint64_t* rec = rb.block->buffer + rb.block->used;
+	if (flags & RESINDEX)
+		*rec++ = index;
+	else {
+		pack(F, rec);
+		rec += recwords;
+	}
+	for (int i = 0; i < 4; i++)
+		*rec++ = counts[i];
+	if (flags & RESWEIGHTS) {
+		int32_t* wt = (int32_t*) rec;
+		for (unsigned i = 0; i < 2*((n+2)/2); i++)
+			wt[i] = (i <= n && w != NULL) ? w[i] : 0;
+		if (w == NULL)
+			rb.unchecked++;
+	}
+	rb.block->used += reswords(flags);
+	rb.count++;
+}
+
+void writeresheader(ofstream& resfile, uint64_t flags, lint count, uint64_t filesum,
+		lint unchecked = 0) {
+	ResultHeader h = ResultHeader();
+	memcpy(h.magic, "GOLDRSLT", 8);
+	h.version = resversion;
+	h.n = n;
+	h.flags = flags;
+	h.count = count;
+	h.recwords = reswords(flags);
+	h.filesum = filesum;
+	h.unchecked = unchecked;
+	resfile.seekp(0);
+	resfile.write((char*) &h, sizeof(h));
+}
+
+// Opens a result file, leaving room for the header, for nbufs testers
+// with two blocks each
+bool openresults(ResultWriter& rw, const char* name, uint64_t flags, int nbufs) {
+	if (!rw.open(name, 2*nbufs))
+		return false;
+	writeresheader(rw.file, flags, 0, 0);
+	return (bool) rw.file;
+}
+
+// Fills in the header once every buffer has been flushed and the writer
+// has caught up; returns the number of records without verified weights
+lint closeresults(ResultWriter& rw, ResultBuffer rbs[], int nbufs,
+		uint64_t flags, uint64_t filesum) {
+	rw.stop();
+	lint count = 0, unchecked = 0;
+	for (int i = 0; i < nbufs; i++) {
+		count += rbs[i].count;
+		unchecked += rbs[i].unchecked;
+	}
+	writeresheader(rw.file, flags, count, filesum, unchecked);
+	rw.file.close();
+	return unchecked;
+}